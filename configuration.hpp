@@ -1,16 +1,143 @@
 #ifndef NMFS__CONFIGURATION_HPP
 #define NMFS__CONFIGURATION_HPP
 
-#include "structures/indexing_types/all.fwd.hpp"
-#include "local_caches/caching_policy/all.fwd.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string_view>
 #include "logger/log_levels.hpp"
 #include "logger/log_locations.hpp"
 
 namespace nmfs::configuration {
 
-using indexing = nmfs::structures::indexing_types::custom::indexing;
-template<typename indexing>
-using caching_policy = nmfs::caching_policies::hold_closed_cache_for<indexing, 30/*seconds*/>;
+/**
+ * Indexing type, caching policy, directory storage, metadata journal and write-ahead log used when they are not given as
+ * mount options
+ */
+constexpr std::string_view default_indexing = "custom";
+constexpr std::string_view default_caching_policy = "ttl";
+constexpr std::string_view default_directory_storage = "object";
+constexpr std::string_view default_metadata_journal = "on";
+constexpr std::string_view default_write_ahead_log = "off";
+
+/**
+ * Duration closed caches are held and considered valid
+ */
+constexpr auto cache_valid_duration = std::chrono::seconds(30);
+/**
+ * Maximum number of nonexistent paths remembered by cache_store
+ */
+constexpr size_t negative_cache_capacity = 64 * 1024;
+/**
+ * Memory budget of cached metadata and directories, used by evict_over_memory_budget policy
+ */
+constexpr size_t cache_memory_budget = 256 * 1024 * 1024;
+/**
+ * Maximum number of closed entries held by adaptive_replacement and window_tiny_lfu policies
+ */
+constexpr size_t cache_capacity = 64 * 1024;
+/**
+ * Duration of a scan epoch of adaptive_replacement and window_tiny_lfu policies, within which touches of an entry count
+ * as one access, so entries touched repeatedly by one scan are not promoted
+ */
+constexpr auto cache_scan_epoch_duration = std::chrono::seconds(1);
+/**
+ * Serialized size over which a directory fragment is split in two
+ */
+constexpr size_t directory_fragment_size = 64 * 1024;
+/**
+ * Number of entries between restart points of a directory fragment, where file names are stored without the prefix
+ * shared with the previous one
+ */
+constexpr size_t directory_restart_interval = 16;
+/**
+ * Number of values listed at once when a directory stored as ordered maps is loaded
+ */
+constexpr size_t directory_listing_size = 1024;
+/**
+ * Number of entries readdir lists and prefetches attributes of at once, until the buffer of the kernel is full
+ */
+constexpr size_t readdir_page_size = 128;
+/**
+ * Size of whole values written to the metadata journal instead of their objects
+ */
+constexpr size_t journaled_value_size = 512;
+/**
+ * Size of journaled values over which a batch is written before next sync
+ */
+constexpr size_t metadata_journal_batch_size = 256 * 1024;
+/**
+ * Size of the active journal segment over which journaled values are written to their objects
+ */
+constexpr size_t metadata_journal_size = 4 * 1024 * 1024;
+/**
+ * Interval operations in the local write-ahead log are replayed to the backend at
+ */
+constexpr auto write_ahead_log_replay_interval = std::chrono::seconds(1);
+/**
+ * Size of operations in the local write-ahead log over which they are replayed before the interval passes
+ */
+constexpr size_t write_ahead_log_batch_size = 16 * 1024 * 1024;
+/**
+ * Size of operations in the local write-ahead log over which writes wait for them to be replayed
+ */
+constexpr size_t write_ahead_log_size = 256 * 1024 * 1024;
+/**
+ * Size of values written to the local write-ahead log, over which they are written to the backend directly
+ */
+constexpr size_t write_ahead_log_value_size = 64 * 1024;
+/**
+ * Number of dirty entries, and their size, over which flushes start early and writers are delayed progressively
+ */
+constexpr size_t dirty_entries_soft_limit = 16 * 1024;
+constexpr size_t dirty_bytes_soft_limit = 64 * 1024 * 1024;
+/**
+ * Number of dirty entries, and their size, at which writers wait for flushes
+ */
+constexpr size_t dirty_entries_hard_limit = 64 * 1024;
+constexpr size_t dirty_bytes_hard_limit = 256 * 1024 * 1024;
+/**
+ * Delay of a writer just under a hard limit of dirty entries
+ */
+constexpr auto dirty_throttle_max_pause = std::chrono::milliseconds(100);
+/**
+ * Number of threads flushing dirty entries concurrently, which bounds concurrent writes of flushes to the backend
+ */
+constexpr size_t flush_parallelism = 16;
+/**
+ * Number of dirty entries flushed by a task of a flusher thread
+ */
+constexpr size_t flush_batch_size = 64;
+/**
+ * Interval of background tasks, and longest interval of flushes while nothing is dirty
+ */
+constexpr auto flush_interval = std::chrono::seconds(5);
+/**
+ * Age of the oldest dirty entry at which it is flushed, shortened in proportion as dirty entries approach their soft
+ * limits
+ */
+constexpr auto dirty_expire_duration = std::chrono::seconds(3);
+/**
+ * Number of backend requests running at once
+ */
+constexpr size_t backend_max_in_flight = 64;
+/**
+ * Number of backend requests of each priority class running at once, in the order of foreground, prefetch, flush and
+ * reclamation
+ */
+constexpr std::array<size_t, 4> backend_class_in_flight = {64, 16, 16, 4};
+/**
+ * Wait of a backend request over which it is admitted ahead of waiting requests of higher priority classes
+ */
+constexpr auto backend_starvation_duration = std::chrono::milliseconds(100);
+/**
+ * Number of threads moving entries of a renamed directory concurrently, for indexing types keyed by paths
+ */
+constexpr size_t rename_parallelism = 32;
+/**
+ * Number of moved entries between progress reports of a directory rename
+ */
+constexpr size_t rename_progress_interval = 4096;
 
 }
 
@@ -0,0 +1,26 @@
+#ifndef NMFS_EXCEPTIONS_INVALID_MOUNT_OPTION_HPP
+#define NMFS_EXCEPTIONS_INVALID_MOUNT_OPTION_HPP
+
+#include <string>
+#include <string_view>
+#include "nmfs_exception.hpp"
+
+namespace nmfs::exceptions {
+
+class invalid_mount_option: public nmfs_exception {
+public:
+    inline explicit invalid_mount_option(std::string_view option);
+
+    [[nodiscard]] inline int error_code() const override;
+};
+
+invalid_mount_option::invalid_mount_option(std::string_view option): nmfs_exception("Invalid mount option: " + std::string(option)) {
+}
+
+int invalid_mount_option::error_code() const {
+    return -EINVAL;
+}
+
+}
+
+#endif //NMFS_EXCEPTIONS_INVALID_MOUNT_OPTION_HPP
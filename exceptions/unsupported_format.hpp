@@ -0,0 +1,25 @@
+#ifndef NMFS_EXCEPTIONS_UNSUPPORTED_FORMAT_HPP
+#define NMFS_EXCEPTIONS_UNSUPPORTED_FORMAT_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "nmfs_exception.hpp"
+
+namespace nmfs::exceptions {
+
+/**
+ * Exception to be thrown when an object is not in a format or version this build can read
+ */
+class unsupported_format: public nmfs_exception {
+public:
+    inline unsupported_format(std::string_view object_type, uint32_t version);
+};
+
+unsupported_format::unsupported_format(std::string_view object_type, uint32_t version)
+    : nmfs_exception("Unsupported format of " + std::string(object_type) + " (version = " + std::to_string(version) + ')') {
+}
+
+}
+
+#endif //NMFS_EXCEPTIONS_UNSUPPORTED_FORMAT_HPP
@@ -13,16 +13,25 @@ namespace nmfs {
 class fuse_directory_filler {
 public:
     /**
-     * The kernel wants to prefill the inode cache during readdir.
-     * This flag can be ignored.
+     * The kernel wants to prefill the inode cache during readdir (READDIRPLUS).
+     * Entries filled without stat are looked up by the kernel later.
      */
     bool prefill_file_stat;
 
     constexpr fuse_directory_filler(void* buffer, fuse_fill_dir_t filler, fuse_readdir_flags flags);
 
+    /**
+     * Offset is what readdir is called with to continue after this entry, or 0 to fill every entry in one call.
+     * @return Nonzero if the buffer is full and this entry wasn't filled
+     */
     template<typename indexing>
-    constexpr int operator()(const char* name, const nmfs::structures::metadata<indexing>& metadata) const;
-    constexpr int operator()(const char* name) const;
+    constexpr int operator()(const char* name, const nmfs::structures::metadata<indexing>& metadata, off_t offset = 0) const;
+    inline int operator()(const char* name, const struct stat& stat, off_t offset = 0) const;
+    /**
+     * Fill only the file type, which is reported to readdir as d_type
+     */
+    inline int operator()(const char* name, mode_t type, off_t offset = 0) const;
+    constexpr int operator()(const char* name, off_t offset = 0) const;
 
 private:
     void* buffer;
@@ -36,13 +45,23 @@ constexpr fuse_directory_filler::fuse_directory_filler(void* buffer, fuse_fill_d
 }
 
 template<typename indexing>
-constexpr int fuse_directory_filler::operator()(const char* name, const nmfs::structures::metadata<indexing>& metadata) const {
+constexpr int fuse_directory_filler::operator()(const char* name, const nmfs::structures::metadata<indexing>& metadata, off_t offset) const {
     struct stat stat = metadata.to_stat();
-    return filler(buffer, name, &stat, 0, FUSE_FILL_DIR_PLUS);
+    return operator()(name, stat, offset);
+}
+
+inline int fuse_directory_filler::operator()(const char* name, const struct stat& stat, off_t offset) const {
+    return filler(buffer, name, &stat, offset, FUSE_FILL_DIR_PLUS);
+}
+
+inline int fuse_directory_filler::operator()(const char* name, mode_t type, off_t offset) const {
+    struct stat stat {};
+    stat.st_mode = type & S_IFMT;
+    return filler(buffer, name, &stat, offset, static_cast<fuse_fill_dir_flags>(0));
 }
 
-constexpr int fuse_directory_filler::operator()(const char* name) const {
-    return filler(buffer, name, nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+constexpr int fuse_directory_filler::operator()(const char* name, off_t offset) const {
+    return filler(buffer, name, nullptr, offset, static_cast<fuse_fill_dir_flags>(0));
 }
 
 }
@@ -5,14 +5,24 @@
 #include <cstring>
 #include <memory>
 #include <cerrno>
+#include <chrono>
 
 #include "fuse_operations.hpp"
 #include "memory_slices/slice.hpp"
+#include "memory_slices/borrower_slice.hpp"
 #include "fuse.hpp"
+#include "mount_options.hpp"
 #include "utils.hpp"
 #include "mapper.hpp"
+#include "configuration.hpp"
 #include "kv_backends/rados_backend.hpp"
+#include "kv_backends/journaled_backend.hpp"
+#include "kv_backends/scheduled_backend.hpp"
+#include "kv_backends/write_ahead_log_backend.hpp"
 #include "exceptions/file_does_not_exist.hpp"
+#include "exceptions/invalid_mount_option.hpp"
+#include "exceptions/unsupported_format.hpp"
+#include "kv_backends/exceptions/key_does_not_exist.hpp"
 #include "logger/log.hpp"
 #include "local_caches/cache_store.impl.hpp"
 #include "local_caches/caching_policy/all.impl.hpp"
@@ -23,33 +33,104 @@
 #include "local_caches/utils/no_lock.hpp"
 
 using namespace nmfs;
-using indexing = configuration::indexing;
 
 static const std::string_view root_path = std::string_view("/");
+/**
+ * Key of the directory storage a file system is created with, where no file is stored as every path begins with a
+ * delimiter
+ */
+static constexpr std::string_view directory_storage_key = "nmfs.directory_storage";
+
+/**
+ * Whether the file system keeps directories as the mount options say, recording it for a file system without a record
+ */
+template<typename indexing>
+static bool check_directory_storage(structures::super_object<indexing>& super_object) {
+    auto& backend = *super_object.backend;
+    std::string_view storage = super_object.options.directory_storage == mount_options::directory_storage_type::ordered_map ? "omap" : "object";
+    DECLARE_CONST_BORROWER_SLICE(key, directory_storage_key.data(), directory_storage_key.size());
 
+    try {
+        std::string recorded = backend.get(key).to_string();
+        if (recorded != storage) {
+            log::error(log_locations::fuse_operation) << "File system keeps directories in " << recorded << " storage, but directory=" << storage << " is given\n";
+            return false;
+        }
+        return true;
+    } catch (kv_backends::exceptions::key_does_not_exist&) {
+    }
+
+    // File systems created before the record was written keep directories in objects
+    bool existing = false;
+    try {
+        existing = backend.exist(indexing::existing_directory_key(super_object, root_path));
+    } catch (nmfs::exceptions::file_does_not_exist&) {
+    }
+    if (existing && storage != "object") {
+        log::error(log_locations::fuse_operation) << "File system keeps directories in object storage, but directory=" << storage << " is given\n";
+        return false;
+    }
+
+    DECLARE_CONST_BORROWER_SLICE(value, storage.data(), storage.size());
+    backend.put(key, value);
+    return true;
+}
+
+template<typename indexing>
 void* nmfs::fuse_operations::init(struct fuse_conn_info* info, struct fuse_config* config) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "()\n";
 #endif
+    // fuse_context->private_data is the mount_options given to fuse_main until init returns
+    auto& options = *static_cast<const mount_options*>(fuse_get_context()->private_data);
     auto connect_information = kv_backends::rados_backend::connect_information {};
-    auto backend = std::make_unique<kv_backends::rados_backend>(connect_information);
-    auto super_object = new structures::super_object<indexing>(std::move(backend));
+    std::unique_ptr<kv_backends::kv_backend> backend = std::make_unique<kv_backends::rados_backend>(connect_information);
+    if (options.metadata_journal) {
+        // Journal left by a crash is replayed here, before anything is read
+        backend = std::make_unique<kv_backends::journaled_backend>(std::move(backend));
+    }
+    if (!options.write_ahead_log_directory.empty()) {
+        // Local log left by a crash is replayed here as well, and fsync waits only for the local device from now on
+        backend = std::make_unique<kv_backends::write_ahead_log_backend>(std::move(backend), options.write_ahead_log_directory);
+    }
+    // Requests of every layer above are admitted by priority classes of their threads
+    backend = std::make_unique<kv_backends::scheduled_backend>(std::move(backend));
+    auto super_object = new structures::super_object<indexing>(std::move(backend), options);
+
+    // refuse to read directories of a file system in a different storage
+    if (!check_directory_storage(*super_object)) {
+        std::cerr << "Mount with the directory storage the file system was created with\n";
+        fuse_exit(fuse_get_context()->fuse);
+        return super_object;
+    }
 
     // initialize memory cache and mapper
     nmfs::next_file_handler = 1;
 
-    // open root metadata
+    // open root metadata, and refuse to mount directories in a format this build can't read
     try {
-        auto& root_directory = super_object->cache->open_directory<no_lock>(root_path).unlock_and_release_directory();
+        auto& root_directory = super_object->cache->template open_directory<no_lock>(root_path).unlock_and_release_directory();
+        static_cast<void>(root_directory.number_of_files());
     } catch (nmfs::exceptions::file_does_not_exist&) {
         fuse_context* fuse_context = fuse_get_context();
-        auto& root_directory = super_object->cache->create_directory<no_lock>(root_path, fuse_context->uid, fuse_context->gid, 0755 | S_IFDIR).unlock_and_release_directory();
+        auto& root_directory = super_object->cache->template create_directory<no_lock>(root_path, fuse_context->uid, fuse_context->gid, 0755 | S_IFDIR).unlock_and_release_directory();
+    } catch (nmfs::exceptions::unsupported_format& e) {
+        std::cerr << e.what() << ": Mount with the version the file system was created with\n";
+        fuse_exit(fuse_get_context()->fuse);
+        return super_object;
     }
 
+    // complete directory renames interrupted by a crash
+    super_object->cache->resume_renames();
+
+    // let the kernel cache nonexistent entries as long as cache_store does
+    config->negative_timeout = std::chrono::duration<double>(super_object->cache->negative_valid_duration()).count();
+
     // set fuse_context->private_data to super_object instance
     return super_object;
 }
 
+template<typename indexing>
 void nmfs::fuse_operations::destroy(void* private_data) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "()\n";
@@ -68,58 +149,109 @@ int nmfs::fuse_operations::statfs(const char* path, struct statvfs* stat) {
     return 0;
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::flush(const char* path, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
 #endif
-    return 0;
+    fuse_context* fuse_context = fuse_get_context();
+    auto& super_object = *static_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+
+    try {
+        auto open_context = file_info? nmfs::open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->template open<std::shared_lock>(path);
+
+        // Called on every close, so attributes are written back without waiting for the backend, which fsync does
+        open_context.metadata.flush();
+
+        if (file_info) {
+            open_context.unlock_and_release();
+        }
+        return 0;
+    } catch (nmfs::exceptions::nmfs_exception& e) {
+        log::debug(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
+        return e.error_code();
+    } catch (std::exception& e) {
+        log::error(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
+        return -EIO;
+    }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::fsync(const char* path, int data_sync, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", data_sync = " << data_sync << ")\n";
 #endif
-
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *static_cast<structures::super_object<indexing>*>(fuse_context->private_data);
-    auto open_context = super_object.cache->open<std::unique_lock>(path);
-    auto& metadata = open_context.metadata;
 
-    // If the datasync parameter is non-zero, then only the user data should be flushed, not the meta data.
+    try {
+        auto open_context = file_info? nmfs::open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->template open<std::shared_lock>(path);
 
-    // TODO : data sync
+        // Metadata is written for fdatasync as well, as it holds the size needed to read data
+        super_object.cache->sync(path, open_context.metadata);
 
-    if (data_sync == 0) {
-        metadata.flush();
+        if (file_info) {
+            open_context.unlock_and_release();
+        }
+        return 0;
+    } catch (nmfs::exceptions::nmfs_exception& e) {
+        log::debug(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
+        return e.error_code();
+    } catch (std::exception& e) {
+        log::error(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
+        return -EIO;
     }
-
-    return 0;
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::fsyncdir(const char* path, int data_sync, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", data_sync = " << data_sync << ")\n";
 #endif
-    return 0;
+    fuse_context* fuse_context = fuse_get_context();
+    auto& super_object = *static_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+
+    try {
+        auto open_context = file_info? directory_open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::directory<indexing>*>(file_info->fh)) : super_object.cache->template open_directory<std::shared_lock>(path);
+
+        super_object.cache->sync(open_context.directory);
+
+        if (file_info) {
+            open_context.unlock_and_release();
+        }
+        return 0;
+    } catch (nmfs::exceptions::nmfs_exception& e) {
+        log::debug(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
+        return e.error_code();
+    } catch (std::exception& e) {
+        log::error(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
+        return -EIO;
+    }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::create(const char* path, mode_t mode, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", mode = 0" << std::oct << mode << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *static_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    // Delayed before any lock is held, while dirty entries are over their soft limits
+    super_object.cache->balance_dirty();
 
     try {
-        auto open_context = super_object.cache->create<std::unique_lock>(path, fuse_context->uid, fuse_context->gid, mode | S_IFREG);
+        auto open_context = super_object.cache->template create<std::unique_lock>(path, fuse_context->uid, fuse_context->gid, mode | S_IFREG);
 
         // add to directory
         std::string_view parent_path = get_parent_directory(path);
         std::string_view file_name = get_filename(path);
 
-        auto parent_open_context = super_object.cache->open_directory<std::unique_lock>(parent_path);
+        // Entries of other fragments may be added and removed meanwhile
+        auto parent_open_context = super_object.cache->template open_directory<std::shared_lock>(parent_path);
         auto& parent_directory = parent_open_context.directory;
         parent_directory.add_file(file_name, open_context.metadata);
+        // A lookup which missed the entry until now doesn't remember it as nonexistent
+        super_object.cache->forget_nonexistent(path);
 
         // Create performs "create and open a file", so we don't close metadata here
         file_info->fh = reinterpret_cast<uint64_t>(&open_context.unlock_and_release());
@@ -133,17 +265,24 @@ int nmfs::fuse_operations::create(const char* path, mode_t mode, struct fuse_fil
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::getattr(const char* path, struct stat* stat, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+
+    if (!file_info && super_object.cache->is_known_nonexistent(path)) {
+        return -ENOENT;
+    }
+    uint64_t nonexistent_generation = super_object.cache->nonexistent_generation();
+
     try {
-        mode_t type = file_info? S_IFREG : indexing::get_type(super_object, path);
+        mode_t type = file_info? S_IFREG : super_object.cache->get_type(path);
 
         if (S_ISREG(type)) {
-            auto open_context = file_info? nmfs::open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->open<std::shared_lock>(path);
+            auto open_context = file_info? nmfs::open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->template open<std::shared_lock>(path);
             auto& metadata = open_context.metadata;
 
             *stat = metadata.to_stat();
@@ -152,10 +291,9 @@ int nmfs::fuse_operations::getattr(const char* path, struct stat* stat, struct f
                 open_context.unlock_and_release();
             }
         } else if (S_ISDIR(type)) {
-            // if directory
-            auto open_context = super_object.cache->open_directory<std::shared_lock>(path);
-            auto& directory = open_context.directory;
-            auto& metadata = directory.directory_metadata;
+            // Entries of the directory are not needed for its attributes
+            auto open_context = super_object.cache->template open_directory_metadata<std::shared_lock>(path);
+            auto& metadata = open_context.metadata;
 
             *stat = metadata.to_stat();
         } else {
@@ -164,6 +302,10 @@ int nmfs::fuse_operations::getattr(const char* path, struct stat* stat, struct f
         }
 
         return 0;
+    } catch (nmfs::exceptions::file_does_not_exist& e) {
+        log::debug(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
+        super_object.cache->remember_nonexistent(path, nonexistent_generation);
+        return e.error_code();
     } catch (nmfs::exceptions::nmfs_exception& e) {
         log::debug(log_locations::fuse_operation) << __func__ << " failed: " << e.what() << '\n';
         return e.error_code();
@@ -173,6 +315,7 @@ int nmfs::fuse_operations::getattr(const char* path, struct stat* stat, struct f
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::open(const char* path, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
@@ -181,7 +324,7 @@ int nmfs::fuse_operations::open(const char* path, struct fuse_file_info* file_in
     auto& super_object = *static_cast<structures::super_object<indexing>*>(fuse_context->private_data);
 
     try {
-        structures::metadata<indexing>& metadata = super_object.cache->open<no_lock>(path).unlock_and_release();
+        structures::metadata<indexing>& metadata = super_object.cache->template open<no_lock>(path).unlock_and_release();
         file_info->fh = reinterpret_cast<uint64_t>(&metadata);
         log::information(log_locations::fuse_operation) << std::hex << std::showbase << __func__ << ": " << path << " = " << &metadata << '\n';
 
@@ -195,24 +338,27 @@ int nmfs::fuse_operations::open(const char* path, struct fuse_file_info* file_in
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::mkdir(const char* path, mode_t mode) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", mode = 0" << std::oct << mode << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *static_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
 
     try {
-        auto new_directory_open_context = super_object.cache->create_directory<std::unique_lock>(path, fuse_context->uid, fuse_context->gid, mode | S_IFDIR);
+        auto new_directory_open_context = super_object.cache->template create_directory<std::unique_lock>(path, fuse_context->uid, fuse_context->gid, mode | S_IFDIR);
         auto& new_directory = new_directory_open_context.directory;
 
         // add to parent directory
         std::string_view parent_path = get_parent_directory(path);
         std::string_view new_directory_name = get_filename(path);
 
-        auto parent_open_context = super_object.cache->open_directory<std::unique_lock>(parent_path);
+        auto parent_open_context = super_object.cache->template open_directory<std::shared_lock>(parent_path);
         auto& parent_directory = parent_open_context.directory;
         parent_directory.add_file(new_directory_name, new_directory.directory_metadata);
+        super_object.cache->forget_nonexistent(path);
 
         return 0;
     } catch (nmfs::exceptions::nmfs_exception& e) {
@@ -224,25 +370,30 @@ int nmfs::fuse_operations::mkdir(const char* path, mode_t mode) {
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::rmdir(const char* path) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *static_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
 
     try {
-        auto open_context = super_object.cache->open_directory<std::unique_lock>(path);
+        auto open_context = super_object.cache->template open_directory<std::unique_lock>(path);
         auto& directory = open_context.directory;
 
         if (directory.number_of_files() > 0) {
             return -ENOTEMPTY;
         } else {
             std::string_view parent_path = get_parent_directory(path);
-            auto parent_open_context = super_object.cache->open_directory<std::unique_lock>(parent_path);
-            auto& parent_directory = parent_open_context.directory;
+            {
+                // Objects of the directory are removed after the parent is closed
+                auto parent_open_context = super_object.cache->template open_directory<std::shared_lock>(parent_path);
+                auto& parent_directory = parent_open_context.directory;
 
-            parent_directory.remove_file(get_filename(path));
+                parent_directory.remove_file(get_filename(path));
+            }
 
             super_object.cache->remove_directory(std::move(open_context));
             return 0;
@@ -256,6 +407,7 @@ int nmfs::fuse_operations::rmdir(const char* path) {
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::write(const char* path, const char* buffer, size_t size, off_t offset, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", size = 0x" << std::hex << size << ", offset = 0x" << offset << ")\n";
@@ -263,9 +415,10 @@ int nmfs::fuse_operations::write(const char* path, const char* buffer, size_t si
     ssize_t written_size;
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
 
     try {
-        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->open<std::unique_lock>(path);
+        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->template open<std::unique_lock>(path);
         auto& metadata = open_context.metadata;
         if (!S_ISREG(metadata.mode)) {
             return -EBADF;
@@ -297,22 +450,27 @@ int nmfs::fuse_operations::fallocate(const char* path, int mode, off_t offset, o
     return 0;
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::unlink(const char* path) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
 
     try {
-        auto open_context = super_object.cache->open<std::unique_lock>(path);
+        auto open_context = super_object.cache->template open<std::unique_lock>(path);
         auto& metadata = open_context.metadata;
 
         std::string_view parent_path = get_parent_directory(path);
-        auto parent_open_context = super_object.cache->open_directory<std::unique_lock>(parent_path);
-        auto& parent_directory = parent_open_context.directory;
+        {
+            // Objects of the file are removed after the parent is closed
+            auto parent_open_context = super_object.cache->template open_directory<std::shared_lock>(parent_path);
+            auto& parent_directory = parent_open_context.directory;
 
-        parent_directory.remove_file(get_filename(path));
+            parent_directory.remove_file(get_filename(path));
+        }
         super_object.cache->remove(std::move(open_context));
 
         return 0;
@@ -325,26 +483,32 @@ int nmfs::fuse_operations::unlink(const char* path) {
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::rename(const char* old_path, const char* new_path, unsigned int flags) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(old_path = " << old_path << ", new_path = " << new_path << ", flags = " << flags << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
 
     if (flags & RENAME_EXCHANGE) {
         return -ENOTSUP;
     }
 
     try {
-        mode_t type = indexing::get_type(super_object, old_path);
+        mode_t type = super_object.cache->get_type(old_path);
         bool target_exist = true;
         mode_t target_type;
 
-        try {
-            target_type = indexing::get_type(super_object, new_path);
-        } catch (nmfs::exceptions::file_does_not_exist&) {
+        if (super_object.cache->is_known_nonexistent(new_path)) {
             target_exist = false;
+        } else {
+            try {
+                target_type = super_object.cache->get_type(new_path);
+            } catch (nmfs::exceptions::file_does_not_exist&) {
+                target_exist = false;
+            }
         }
 
         if ((flags & RENAME_NOREPLACE) && target_exist) {
@@ -352,7 +516,7 @@ int nmfs::fuse_operations::rename(const char* old_path, const char* new_path, un
         } else if (S_ISDIR(type)) {
             if (target_exist) {
                 if (S_ISDIR(target_type)) {
-                    auto target_open_context = super_object.cache->open_directory<std::unique_lock>(new_path);
+                    auto target_open_context = super_object.cache->template open_directory<std::unique_lock>(new_path);
                     auto& target_directory = target_open_context.directory;
 
                     if (target_directory.empty()) {
@@ -371,7 +535,7 @@ int nmfs::fuse_operations::rename(const char* old_path, const char* new_path, un
         } else if (S_ISREG(type)) {
             if (target_exist) {
                 if (!S_ISDIR(target_type)) {
-                    auto target_open_context = super_object.cache->open<std::unique_lock>(new_path);
+                    auto target_open_context = super_object.cache->template open<std::unique_lock>(new_path);
                     super_object.cache->remove(std::move(target_open_context));
                     /* Proceeds to moving regular file */
                 } else {
@@ -388,16 +552,26 @@ int nmfs::fuse_operations::rename(const char* old_path, const char* new_path, un
         /* Directory management */
         std::string_view old_parent_path = get_parent_directory(old_path);
         std::string_view new_parent_path = get_parent_directory(new_path);
-        auto old_parent_open_context = super_object.cache->open_directory<std::unique_lock>(old_parent_path);
+        auto old_parent_open_context = super_object.cache->template open_directory<std::unique_lock>(old_parent_path);
         auto& old_parent_directory = old_parent_open_context.directory;
 
         if (old_parent_path == new_parent_path) {
             old_parent_directory.move_entry(old_path, new_path, old_parent_directory);
         } else {
-            auto new_parent_open_context = super_object.cache->open_directory<std::unique_lock>(new_parent_path);
+            auto new_parent_open_context = super_object.cache->template open_directory<std::unique_lock>(new_parent_path);
             auto& new_parent_directory = new_parent_open_context.directory;
 
             old_parent_directory.move_entry(old_path, new_path, new_parent_directory);
+            if (S_ISDIR(type)) {
+                new_parent_directory.flush();
+            }
+        }
+        super_object.cache->forget_nonexistent(new_path);
+
+        if (S_ISDIR(type)) {
+            // Parents are written before the rename is forgotten, so a crash never leaves them listing the old path
+            old_parent_directory.flush();
+            super_object.cache->finish_rename(old_path);
         }
 
         return 0;
@@ -410,20 +584,24 @@ int nmfs::fuse_operations::rename(const char* old_path, const char* new_path, un
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::chmod(const char* path, mode_t mode, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", mode = 0" << std::oct << mode << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
 
     try {
-        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->open<std::unique_lock>(path);
+        mode_t type = file_info? S_IFREG : super_object.cache->get_type(path);
+        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) :
+                            S_ISDIR(type)? super_object.cache->template open_directory_metadata<std::unique_lock>(path) : super_object.cache->template open<std::unique_lock>(path);
         auto& metadata = open_context.metadata;
 
         mode_t file_type = mode & S_IFMT;
         metadata.mode = mode | file_type;
-        metadata.dirty = true;
+        metadata.mark_dirty();
 
         if (file_info) {
             open_context.unlock_and_release();
@@ -439,20 +617,24 @@ int nmfs::fuse_operations::chmod(const char* path, mode_t mode, struct fuse_file
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::chown(const char* path, uid_t uid, gid_t gid, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", uid = " << uid << ", gid = " << gid << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
 
     try {
-        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->open<std::unique_lock>(path);
+        mode_t type = file_info? S_IFREG : super_object.cache->get_type(path);
+        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) :
+                            S_ISDIR(type)? super_object.cache->template open_directory_metadata<std::unique_lock>(path) : super_object.cache->template open<std::unique_lock>(path);
         auto& metadata = open_context.metadata;
 
         metadata.owner = uid;
         metadata.group = gid;
-        metadata.dirty = true;
+        metadata.mark_dirty();
 
         if (file_info) {
             open_context.unlock_and_release();
@@ -468,14 +650,16 @@ int nmfs::fuse_operations::chown(const char* path, uid_t uid, gid_t gid, struct
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::truncate(const char* path, off_t length, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", length = 0x" << std::hex << length << ")\n";
 #endif
     fuse_context* fuse_context = fuse_get_context();
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
+    super_object.cache->balance_dirty();
     try {
-        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->open<std::unique_lock>(path);
+        auto open_context = file_info? nmfs::open_context<indexing, std::unique_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->template open<std::unique_lock>(path);
         auto& metadata = open_context.metadata;
 
         metadata.truncate(length);
@@ -494,6 +678,7 @@ int nmfs::fuse_operations::truncate(const char* path, off_t length, struct fuse_
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::read(const char* path, char* buffer, size_t size, off_t offset, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ", size = 0x" << std::hex << size << ", offset = 0x" << offset << ")\n";
@@ -504,7 +689,7 @@ int nmfs::fuse_operations::read(const char* path, char* buffer, size_t size, off
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
 
     try {
-        auto open_context = file_info? nmfs::open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->open<std::shared_lock>(path);
+        auto open_context = file_info? nmfs::open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::metadata<indexing>*>(file_info->fh)) : super_object.cache->template open<std::shared_lock>(path);
         auto& metadata = open_context.metadata;
         read_size = metadata.read(buffer, size, offset);
 
@@ -525,6 +710,7 @@ int nmfs::fuse_operations::read(const char* path, char* buffer, size_t size, off
 
 int nmfs::fuse_operations::read_buf(const char* path, struct fuse_bufvec** buffer, size_t size, off_t offset, struct fuse_file_info* file_info);
 
+template<typename indexing>
 int nmfs::fuse_operations::opendir(const char* path, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
@@ -533,7 +719,7 @@ int nmfs::fuse_operations::opendir(const char* path, struct fuse_file_info* file
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
 
     try {
-        auto& directory = super_object.cache->open_directory<no_lock>(path).unlock_and_release_directory();
+        auto& directory = super_object.cache->template open_directory<no_lock>(path).unlock_and_release_directory();
 
         file_info->fh = reinterpret_cast<uint64_t>(&directory);
 
@@ -547,6 +733,7 @@ int nmfs::fuse_operations::opendir(const char* path, struct fuse_file_info* file
     }
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::readdir(const char* path, void* buffer, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info* file_info, enum fuse_readdir_flags readdir_flags) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
@@ -555,13 +742,27 @@ int nmfs::fuse_operations::readdir(const char* path, void* buffer, fuse_fill_dir
     auto& super_object = *reinterpret_cast<structures::super_object<indexing>*>(fuse_context->private_data);
 
     try {
-        auto open_context = file_info? directory_open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::directory<indexing>*>(file_info->fh)) : super_object.cache->open_directory<std::shared_lock>(path);
+        auto open_context = file_info? directory_open_context<indexing, std::shared_lock>(path, *reinterpret_cast<structures::directory<indexing>*>(file_info->fh)) : super_object.cache->template open_directory<std::shared_lock>(path);
         auto& directory = open_context.directory;
 
-        filler(buffer, ".", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
-        filler(buffer, "..", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+        auto directory_filler = fuse_directory_filler(buffer, filler, readdir_flags);
+        // "." and ".." take offsets 1 and 2, and entries continue from their cursors, so a listing resumes where the buffer got full
+        bool full = offset < 1 && directory_filler(".", static_cast<off_t>(1)) != 0;
+        full = full || (offset < 2 && directory_filler("..", static_cast<off_t>(2)) != 0);
+
+        for (off_t cursor = offset; !full;) {
+            auto entries = directory.read_entries(cursor, configuration::readdir_page_size);
+            if (entries.empty()) {
+                break;
+            }
 
-        directory.fill_buffer(fuse_directory_filler(buffer, filler, readdir_flags));
+            if (directory_filler.prefill_file_stat) {
+                full = !directory.fill_buffer(directory_filler, entries, super_object.cache->stat_entries(path, entries));
+            } else {
+                full = !directory.fill_buffer(directory_filler, entries);
+            }
+            cursor = entries.back().cursor;
+        }
 
         if (file_info) {
             open_context.unlock_and_release_directory();
@@ -584,6 +785,7 @@ int nmfs::fuse_operations::access(const char* path, int mask) {
     return 0;
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::release(const char* path, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
@@ -598,6 +800,7 @@ int nmfs::fuse_operations::release(const char* path, struct fuse_file_info* file
     return 0;
 }
 
+template<typename indexing>
 int nmfs::fuse_operations::releasedir(const char* path, struct fuse_file_info* file_info) {
 #ifdef DEBUG
     log::information(log_locations::fuse_operation) << __func__ << "(path = " << path << ")\n";
@@ -621,38 +824,73 @@ int nmfs::fuse_operations::utimens(const char* path, const struct timespec tv[2]
     return 0;
 }
 
+template<typename indexing>
 ::fuse_operations nmfs::fuse_operations::get_fuse_ops() {
     ::fuse_operations operations;
     memset(&operations, 0, sizeof(::fuse_operations));
 
-    operations.init = init;
-    operations.destroy = destroy;
+    operations.init = init<indexing>;
+    operations.destroy = destroy<indexing>;
     //operations.statfs = statfs;
-    //operations.flush = flush;
-    //operations.fsync = fsync;
-    //operations.fsyncdir = fsyncdir;
+    operations.flush = flush<indexing>;
+    operations.fsync = fsync<indexing>;
+    operations.fsyncdir = fsyncdir<indexing>;
 
-    operations.mkdir = mkdir;
-    operations.rmdir = rmdir;
-    operations.write = write;
+    operations.mkdir = mkdir<indexing>;
+    operations.rmdir = rmdir<indexing>;
+    operations.write = write<indexing>;
     //operations.fallocate = fallocate;
-    operations.create = create;
-    operations.unlink = unlink;
-
-    operations.rename = rename;
-    operations.chmod = chmod;
-    operations.chown = chown;
-    operations.truncate = truncate;
-
-    operations.getattr = getattr;
-    operations.open = open;
-    operations.read = read;
-    operations.opendir = opendir;
-    operations.readdir = readdir;
+    operations.create = create<indexing>;
+    operations.unlink = unlink<indexing>;
+
+    operations.rename = rename<indexing>;
+    operations.chmod = chmod<indexing>;
+    operations.chown = chown<indexing>;
+    operations.truncate = truncate<indexing>;
+
+    operations.getattr = getattr<indexing>;
+    operations.open = open<indexing>;
+    operations.read = read<indexing>;
+    operations.opendir = opendir<indexing>;
+    operations.readdir = readdir<indexing>;
     operations.access = access;
 
-    operations.release = release;
-    operations.releasedir = releasedir;
+    operations.release = release<indexing>;
+    operations.releasedir = releasedir<indexing>;
     operations.utimens = utimens;
     return operations;
 }
+
+template<template<typename> typename caching_policy>
+static ::fuse_operations get_fuse_ops_with(const mount_options& options) {
+    switch (options.indexing) {
+        case mount_options::indexing_type::custom:
+            return nmfs::fuse_operations::get_fuse_ops<structures::indexing_types::custom::indexing<caching_policy>>();
+        case mount_options::indexing_type::full_path:
+            return nmfs::fuse_operations::get_fuse_ops<structures::indexing_types::full_path::indexing<caching_policy>>();
+        case mount_options::indexing_type::inline_attributes:
+            return nmfs::fuse_operations::get_fuse_ops<structures::indexing_types::inline_attributes::indexing<caching_policy>>();
+        case mount_options::indexing_type::inode:
+            return nmfs::fuse_operations::get_fuse_ops<structures::indexing_types::inode::indexing<caching_policy>>();
+        default:
+            throw nmfs::exceptions::invalid_mount_option("indexing");
+    }
+}
+
+::fuse_operations nmfs::fuse_operations::get_fuse_ops(const mount_options& options) {
+    // The only dispatch on mount options. Every operation below is specialized for the selected types.
+    switch (options.caching_policy) {
+        case mount_options::caching_policy_type::hold_closed_cache_for:
+            return get_fuse_ops_with<caching_policies::hold_closed_cache_for>(options);
+        case mount_options::caching_policy_type::evict_on_last_close:
+            return get_fuse_ops_with<caching_policies::evict_on_last_close>(options);
+        case mount_options::caching_policy_type::evict_over_memory_budget:
+            return get_fuse_ops_with<caching_policies::evict_over_memory_budget>(options);
+        case mount_options::caching_policy_type::adaptive_replacement:
+            return get_fuse_ops_with<caching_policies::adaptive_replacement>(options);
+        case mount_options::caching_policy_type::window_tiny_lfu:
+            return get_fuse_ops_with<caching_policies::window_tiny_lfu>(options);
+        default:
+            throw nmfs::exceptions::invalid_mount_option("cache");
+    }
+}
@@ -3,42 +3,69 @@
 
 #include <rados/librados.hpp>
 #include "fuse.hpp"
+#include "mount_options.hpp"
 
 namespace nmfs::fuse_operations {
 
+template<typename indexing>
 void* init(struct fuse_conn_info* info, struct fuse_config *config);
+template<typename indexing>
 void destroy(void* private_data);
 int statfs(const char* path, struct statvfs* stat);
+template<typename indexing>
 int flush(const char* path, struct fuse_file_info* file_info);
+template<typename indexing>
 int fsync(const char* path, int data_sync, struct fuse_file_info* file_info);
+template<typename indexing>
 int fsyncdir(const char* path, int data_sync, struct fuse_file_info* file_info);
 
+template<typename indexing>
 int mkdir(const char* path, mode_t mode);
+template<typename indexing>
 int rmdir(const char* path);
+template<typename indexing>
 int write(const char* path, const char* buffer, size_t size, off_t offset, struct fuse_file_info* file_info);
 int write_buf(const char* path, struct fuse_bufvec* buffer, off_t offset, struct fuse_file_info* file_info);
 int fallocate(const char* path, int mode, off_t offset, off_t length, struct fuse_file_info* file_info);
+template<typename indexing>
 int create(const char* path, mode_t mode, struct fuse_file_info* file_info);
+template<typename indexing>
 int unlink(const char* path);
 
+template<typename indexing>
 int rename(const char* old_path, const char* new_path, unsigned int flags);
+template<typename indexing>
 int chmod(const char* path, mode_t mode, struct fuse_file_info* file_info);
+template<typename indexing>
 int chown(const char* path, uid_t uid, gid_t gid, struct fuse_file_info* file_info);
+template<typename indexing>
 int truncate(const char* path, off_t length, struct fuse_file_info* file_info);
 
+template<typename indexing>
 int getattr(const char* path, struct stat* stat, struct fuse_file_info* file_info);
+template<typename indexing>
 int open(const char* path, struct fuse_file_info* file_info);
+template<typename indexing>
 int read(const char* path, char* buffer, size_t size, off_t offset, struct fuse_file_info* file_info);
+template<typename indexing>
 int opendir(const char* path, struct fuse_file_info* file_info);
+template<typename indexing>
 int readdir(const char* path, void* buffer, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info* file_info, enum fuse_readdir_flags readdir_flags);
 int access(const char* path, int mask);
 int read_buf(const char* path, struct fuse_bufvec** buffer, size_t size, off_t offset, struct fuse_file_info* file_info);
 
+template<typename indexing>
 int release(const char* path, struct fuse_file_info* file_info);
+template<typename indexing>
 int releasedir(const char* path, struct fuse_file_info* file_info);
 int utimens(const char *, const struct timespec tv[2], struct fuse_file_info *fi);
 
+template<typename indexing>
 ::fuse_operations get_fuse_ops();
+/**
+ * Select operations specialized for the indexing type and caching policy in options
+ */
+::fuse_operations get_fuse_ops(const mount_options& options);
 
 } // namespace nmfs::fuse_operations
 
@@ -0,0 +1,63 @@
+#ifndef NMFS_KV_BACKENDS_IO_PRIORITY_HPP
+#define NMFS_KV_BACKENDS_IO_PRIORITY_HPP
+
+#include <cstddef>
+
+namespace nmfs::kv_backends {
+
+/**
+ * Priority classes of backend requests, from the highest
+ */
+enum class io_priority {
+    /**
+     * Requests a file system operation waits for, which is the default of every thread
+     */
+    foreground,
+    /**
+     * Requests reading values ahead of operations which may need them
+     */
+    prefetch,
+    /**
+     * Requests writing dirty entries in the background
+     */
+    flush,
+    /**
+     * Requests removing data objects of deleted and truncated files, which cache_store runs in the background
+     */
+    reclamation,
+};
+
+constexpr size_t number_of_io_priorities = 4;
+
+/**
+ * Priority class of backend requests made by this thread while it lives
+ */
+class io_priority_scope {
+public:
+    explicit inline io_priority_scope(io_priority priority);
+    io_priority_scope(const io_priority_scope&) = delete;
+    inline ~io_priority_scope();
+
+    [[nodiscard]] static inline io_priority current();
+
+private:
+    static inline thread_local io_priority current_priority = io_priority::foreground;
+    io_priority previous_priority;
+};
+
+inline io_priority_scope::io_priority_scope(io_priority priority)
+    : previous_priority(current_priority) {
+    current_priority = priority;
+}
+
+inline io_priority_scope::~io_priority_scope() {
+    current_priority = previous_priority;
+}
+
+inline io_priority io_priority_scope::current() {
+    return current_priority;
+}
+
+}
+
+#endif //NMFS_KV_BACKENDS_IO_PRIORITY_HPP
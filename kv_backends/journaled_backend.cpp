@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "journaled_backend.hpp"
+#include "exceptions/key_does_not_exist.hpp"
+#include "../configuration.hpp"
+#include "../memory_slices/borrower_slice.hpp"
+#include "../logger/log.hpp"
+
+using namespace nmfs::kv_backends::exceptions;
+
+nmfs::kv_backends::journaled_backend::journaled_backend(std::unique_ptr<kv_backend> backend)
+    : backend(std::move(backend)) {
+    replay();
+    checkpointer = std::thread(&journaled_backend::checkpointer_main, this);
+}
+
+nmfs::kv_backends::journaled_backend::~journaled_backend() {
+    {
+        auto lock = std::unique_lock(checkpointer_mutex);
+        stop_checkpointer = true;
+    }
+    checkpointer_wakeup.notify_one();
+    checkpointer.join();
+
+    // Nothing is left in the journal after a clean unmount
+    try {
+        checkpoint();
+    } catch (kv_backend_exception& e) {
+        log::error(log_locations::kv_backend_operation) << "journaled_backend::checkpoint failed, values are replayed on next mount: " << e.what() << '\n';
+    }
+}
+
+nmfs::owner_slice nmfs::kv_backends::journaled_backend::get(const nmfs::slice& key) {
+    if (auto journaled = find(key)) {
+        if (!journaled->value.has_value()) {
+            throw key_does_not_exist(key);
+        }
+        return std::move(*journaled->value);
+    }
+    return backend->get(key);
+}
+
+nmfs::owner_slice nmfs::kv_backends::journaled_backend::get(const nmfs::slice& key, size_t length, off_t offset) {
+    if (auto journaled = find(key)) {
+        if (!journaled->value.has_value()) {
+            throw key_does_not_exist(key);
+        }
+
+        const owner_slice& value = *journaled->value;
+        size_t begin = std::min(value.size(), static_cast<size_t>(offset));
+        auto result = owner_slice(std::min(length, value.size() - begin));
+        std::copy(value.cbegin() + begin, value.cbegin() + begin + result.size(), result.data());
+        return result;
+    }
+    return backend->get(key, length, offset);
+}
+
+ssize_t nmfs::kv_backends::journaled_backend::get(const nmfs::slice& key, nmfs::slice& value) { // fully read
+    if (auto journaled = find(key)) {
+        if (!journaled->value.has_value()) {
+            throw key_does_not_exist(key);
+        } else if (journaled->value->size() > value.capacity()) {
+            throw std::out_of_range("journaled_backend::get : capacity of value slice is not enough");
+        }
+
+        std::copy(journaled->value->cbegin(), journaled->value->cend(), value.data());
+        value.set_size(journaled->value->size());
+        return static_cast<ssize_t>(value.size());
+    }
+    return backend->get(key, value);
+}
+
+ssize_t nmfs::kv_backends::journaled_backend::get(const nmfs::slice& key, off_t offset, size_t length, nmfs::slice& value) { // partial read
+    if (auto journaled = find(key)) {
+        if (!journaled->value.has_value()) {
+            throw key_does_not_exist(key);
+        } else if (length > value.capacity()) {
+            throw std::out_of_range("journaled_backend::get : returned object size exceeds capacity of value slice");
+        }
+
+        const owner_slice& journaled_value = *journaled->value;
+        size_t begin = std::min(journaled_value.size(), static_cast<size_t>(offset));
+        size_t size = std::min(length, journaled_value.size() - begin);
+        std::copy(journaled_value.cbegin() + begin, journaled_value.cbegin() + begin + size, value.data());
+        value.set_size(size);
+        return static_cast<ssize_t>(size);
+    }
+    return backend->get(key, offset, length, value);
+}
+
+std::vector<std::optional<nmfs::owner_slice>> nmfs::kv_backends::journaled_backend::get(const std::vector<owner_slice>& keys, size_t length) { // batched partial read
+    auto values = backend->get(keys, length);
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (auto journaled = find(keys[i])) {
+            if (journaled->value.has_value()) {
+                auto& value = values[i].emplace(std::min(length, journaled->value->size()));
+                std::copy(journaled->value->cbegin(), journaled->value->cbegin() + value.size(), value.data());
+            } else {
+                values[i].reset();
+            }
+        }
+    }
+    return values;
+}
+
+ssize_t nmfs::kv_backends::journaled_backend::put(const nmfs::slice& key, const nmfs::slice& value) { // fully write
+    if (value.size() <= configuration::journaled_value_size || find(key).has_value()) {
+        journal(key, owner_slice(value));
+        return 0;
+    }
+    // Values journaled before are committed first, so objects are written in the order of calls
+    sync();
+    return backend->put(key, value);
+}
+
+ssize_t nmfs::kv_backends::journaled_backend::put(const nmfs::slice& key, off_t offset, const nmfs::slice& value) { // partial write
+    if (auto journaled = find(key)) {
+        // Written as a whole value, as the object may not be written yet
+        size_t old_size = journaled->value.has_value() ? journaled->value->size() : 0;
+        auto merged = owner_slice(std::max(old_size, offset + value.size()));
+
+        std::fill(merged.begin(), merged.end(), 0);
+        if (journaled->value.has_value()) {
+            std::copy(journaled->value->cbegin(), journaled->value->cend(), merged.data());
+        }
+        std::copy(value.cbegin(), value.cend(), merged.data() + offset);
+        journal(key, std::move(merged));
+        return 0;
+    }
+    sync();
+    return backend->put(key, offset, value);
+}
+
+bool nmfs::kv_backends::journaled_backend::exist(const nmfs::slice& key) {
+    if (auto journaled = find(key)) {
+        return journaled->value.has_value();
+    }
+    return backend->exist(key);
+}
+
+void nmfs::kv_backends::journaled_backend::remove(const nmfs::slice& key) {
+    if (find(key).has_value()) {
+        journal(key, std::nullopt);
+    } else {
+        // A value journaled before, such as a header referring to the object, must not be lost while it is removed
+        sync();
+        backend->remove(key);
+    }
+}
+
+void nmfs::kv_backends::journaled_backend::move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) {
+    std::vector<owner_slice> unjournaled_old_keys;
+    std::vector<owner_slice> unjournaled_new_keys;
+
+    for (size_t i = 0; i < old_keys.size(); i++) {
+        if (auto journaled = find(old_keys[i])) {
+            if (journaled->value.has_value()) {
+                journal(new_keys[i], std::move(journaled->value));
+                journal(old_keys[i], std::nullopt);
+            }
+        } else {
+            unjournaled_old_keys.push_back(old_keys[i]);
+            unjournaled_new_keys.push_back(new_keys[i]);
+        }
+    }
+
+    bool overwrites_journaled = std::any_of(unjournaled_new_keys.cbegin(), unjournaled_new_keys.cend(), [this](const owner_slice& key) {
+        return find(key).has_value();
+    });
+    if (overwrites_journaled) {
+        // Journaled values of new keys are written before their copies, instead of over them by the next checkpoint
+        checkpoint();
+    } else {
+        sync();
+    }
+    backend->move(unjournaled_old_keys, unjournaled_new_keys);
+}
+
+void nmfs::kv_backends::journaled_backend::update_map(const nmfs::slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) {
+    sync();
+    backend->update_map(key, values, removed_map_keys);
+}
+
+bool nmfs::kv_backends::journaled_backend::list_map(const nmfs::slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) {
+    return backend->list_map(key, after, max_values, values);
+}
+
+void nmfs::kv_backends::journaled_backend::sync() {
+    auto lock = std::unique_lock(commit_mutex);
+    commit();
+}
+
+std::optional<nmfs::kv_backends::journaled_backend::journaled_value> nmfs::kv_backends::journaled_backend::find(const nmfs::slice& key) {
+    auto lock = std::shared_lock(mutex);
+    auto iterator = journaled_values.find(key.to_string());
+
+    if (iterator != journaled_values.end()) {
+        return iterator->second;
+    } else {
+        return std::nullopt;
+    }
+}
+
+void nmfs::kv_backends::journaled_backend::journal(const nmfs::slice& key, std::optional<owner_slice> value) {
+    auto record = on_disk_record {
+        .key_size = static_cast<uint32_t>(key.size()),
+        .value_size = static_cast<uint32_t>(value.has_value() ? value->size() : 0),
+        .removed = !value.has_value(),
+    };
+    auto lock = std::unique_lock(mutex);
+
+    auto record_bytes = reinterpret_cast<const byte*>(&record);
+    batch.insert(batch.end(), record_bytes, record_bytes + sizeof(record));
+    batch.insert(batch.end(), key.cbegin(), key.cend());
+    if (value.has_value()) {
+        batch.insert(batch.end(), value->cbegin(), value->cend());
+    }
+    journaled_values.insert_or_assign(key.to_string(), journaled_value {
+        .value = std::move(value),
+        .segment = active_segment,
+    });
+    bool full = batch.size() >= configuration::metadata_journal_batch_size;
+    lock.unlock();
+
+    if (full) {
+        sync();
+    }
+}
+
+void nmfs::kv_backends::journaled_backend::commit() {
+    auto lock = std::unique_lock(mutex);
+    if (batch.empty()) {
+        return;
+    }
+
+    auto records = std::move(batch);
+    batch.clear();
+    uint64_t segment = active_segment;
+    size_t offset = active_segment_size;
+    active_segment_size += records.size();
+    bool full = active_segment_size >= configuration::metadata_journal_size;
+    lock.unlock();
+
+    auto key = segment_key(segment);
+    DECLARE_CONST_BORROWER_SLICE(key_slice, key.data(), key.size());
+    DECLARE_CONST_BORROWER_SLICE(value, records.data(), records.size());
+    backend->put(key_slice, static_cast<off_t>(offset), value);
+    log::information(log_locations::kv_backend_operation)
+        << "journaled_backend::commit : (segment = " << segment << ", offset = " << offset << ", size = " << records.size() << ")\n";
+
+    if (full) {
+        request_checkpoint();
+    }
+}
+
+void nmfs::kv_backends::journaled_backend::checkpoint() {
+    auto checkpoint_lock = std::unique_lock(checkpoint_mutex);
+    std::vector<std::pair<std::string, std::optional<owner_slice>>> values;
+    uint64_t last_sealed_segment;
+
+    {
+        // New values are journaled to the next segment while sealed ones are written
+        auto commit_lock = std::unique_lock(commit_mutex);
+        commit();
+
+        auto lock = std::unique_lock(mutex);
+        if (active_segment_size > 0) {
+            active_segment++;
+            active_segment_size = 0;
+        }
+        if (active_segment == first_segment) {
+            return;
+        }
+        last_sealed_segment = active_segment - 1;
+
+        for (const auto& [key, journaled]: journaled_values) {
+            if (journaled.segment <= last_sealed_segment) {
+                values.emplace_back(key, journaled.value);
+            }
+        }
+    }
+
+    for (const auto& [key, value]: values) {
+        DECLARE_CONST_BORROWER_SLICE(key_slice, key.data(), key.size());
+        if (value.has_value()) {
+            backend->put(key_slice, *value);
+        } else {
+            backend->remove(key_slice);
+        }
+    }
+
+    // Sealed segments are skipped on replay once the head is written
+    uint64_t next_segment = last_sealed_segment + 1;
+    DECLARE_CONST_BORROWER_SLICE(head_key_slice, head_key.data(), head_key.size());
+    DECLARE_CONST_BORROWER_SLICE(head, &next_segment, sizeof(next_segment));
+    backend->put(head_key_slice, head);
+    for (uint64_t segment = first_segment; segment <= last_sealed_segment; segment++) {
+        auto key = segment_key(segment);
+        DECLARE_CONST_BORROWER_SLICE(key_slice, key.data(), key.size());
+        backend->remove(key_slice);
+    }
+
+    auto lock = std::unique_lock(mutex);
+    std::erase_if(journaled_values, [last_sealed_segment](const auto& item) {
+        return item.second.segment <= last_sealed_segment;
+    });
+    first_segment = next_segment;
+    log::information(log_locations::kv_backend_operation)
+        << "journaled_backend::checkpoint : (number of values = " << values.size() << ", next segment = " << next_segment << ")\n";
+}
+
+void nmfs::kv_backends::journaled_backend::replay() {
+    DECLARE_CONST_BORROWER_SLICE(head_key_slice, head_key.data(), head_key.size());
+
+    try {
+        owner_slice head = backend->get(head_key_slice);
+        std::memcpy(&first_segment, head.data(), sizeof(first_segment));
+    } catch (key_does_not_exist&) {
+        first_segment = 0;
+    }
+
+    uint64_t segment = first_segment;
+    while (true) {
+        auto key = segment_key(segment);
+        DECLARE_CONST_BORROWER_SLICE(key_slice, key.data(), key.size());
+        std::optional<owner_slice> segment_records;
+
+        try {
+            segment_records.emplace(backend->get(key_slice));
+        } catch (key_does_not_exist&) {
+            break;
+        }
+        const owner_slice& records = *segment_records;
+
+        // A batch is written by one operation, so a segment never ends in the middle of a record
+        const byte* current = records.data();
+        while (current < records.data() + records.size()) {
+            on_disk_record record {};
+            std::memcpy(&record, current, sizeof(record));
+            current += sizeof(record);
+
+            auto record_key = std::string(reinterpret_cast<const char*>(current), record.key_size);
+            current += record.key_size;
+            std::optional<owner_slice> value;
+            if (!record.removed) {
+                value.emplace(record.value_size);
+                std::copy(current, current + record.value_size, value->data());
+                current += record.value_size;
+            }
+            journaled_values.insert_or_assign(std::move(record_key), journaled_value {
+                .value = std::move(value),
+                .segment = segment,
+            });
+        }
+        log::information(log_locations::kv_backend_operation)
+            << "journaled_backend::replay : (segment = " << segment << ", size = " << records.size() << ")\n";
+        segment++;
+    }
+
+    active_segment = segment;
+    active_segment_size = 0;
+    checkpoint_requested = active_segment != first_segment;
+}
+
+void nmfs::kv_backends::journaled_backend::checkpointer_main() {
+    auto lock = std::unique_lock(checkpointer_mutex);
+
+    while (true) {
+        checkpointer_wakeup.wait(lock, [this]() {
+            return stop_checkpointer || checkpoint_requested;
+        });
+        if (stop_checkpointer) {
+            return;
+        }
+        checkpoint_requested = false;
+        lock.unlock();
+
+        try {
+            checkpoint();
+        } catch (kv_backend_exception& e) {
+            // Values stay journaled, and are written by next checkpoint
+            log::error(log_locations::kv_backend_operation) << "journaled_backend::checkpoint failed: " << e.what() << '\n';
+        }
+        lock.lock();
+    }
+}
+
+void nmfs::kv_backends::journaled_backend::request_checkpoint() {
+    {
+        auto lock = std::unique_lock(checkpointer_mutex);
+        checkpoint_requested = true;
+    }
+    checkpointer_wakeup.notify_one();
+}
+
+std::string nmfs::kv_backends::journaled_backend::segment_key(uint64_t segment) {
+    return std::string(head_key) + '.' + std::to_string(segment);
+}
@@ -0,0 +1,125 @@
+#ifndef NMFS_KV_BACKENDS_JOURNALED_BACKEND_HPP
+#define NMFS_KV_BACKENDS_JOURNALED_BACKEND_HPP
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "kv_backend.hpp"
+
+namespace nmfs::kv_backends {
+
+/**
+ * Backend which appends small values to a journal instead of writing them to their objects
+ *
+ * Whole values up to configuration::journaled_value_size, which are mostly metadata, are appended to a batch, and the
+ * batch is written to the active journal segment at once by sync or when it grows over
+ * configuration::metadata_journal_batch_size. So a burst of metadata changes costs one write per batch instead of one
+ * per object. Later operations on a journaled key, including removal, are journaled as well until a checkpoint.
+ *
+ * When the active segment grows over configuration::metadata_journal_size, a background thread seals it, writes the
+ * last value of each key to its object and removes the sealed segments. Journaled values are served from memory
+ * until then, and segments left by a crash are read on construction and checkpointed.
+ *
+ * Values of ordered maps and values not journaled are written to their objects directly, after the batch is committed,
+ * so objects are changed in the order of calls across a crash.
+ */
+class journaled_backend: public kv_backend {
+public:
+    explicit journaled_backend(std::unique_ptr<kv_backend> backend);
+    ~journaled_backend() override;
+
+    [[nodiscard]] owner_slice get(const slice& key) final;
+    [[nodiscard]] owner_slice get(const slice& key, size_t length, off_t offset) final;
+    ssize_t get(const slice& key, slice& value) final; // fully read
+    ssize_t get(const slice& key, off_t offset, size_t length, slice& value) final; // partial read
+    [[nodiscard]] std::vector<std::optional<owner_slice>> get(const std::vector<owner_slice>& keys, size_t length) final; // batched partial read
+
+    ssize_t put(const slice& key, const slice& value) final; // fully write
+    ssize_t put(const slice& key, off_t offset, const slice& value) final; // partial write
+
+    [[nodiscard]] bool exist(const slice& key) final;
+    void remove(const slice& key) final;
+    void move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) final;
+
+    void update_map(const slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) final;
+    bool list_map(const slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) final;
+
+    /**
+     * Write the batch to the active segment
+     */
+    void sync() final;
+
+private:
+    /**
+     * Last journaled value of a key, which is std::nullopt if the key is removed
+     */
+    struct journaled_value {
+        std::optional<owner_slice> value;
+        uint64_t segment;
+    };
+
+    /**
+     * Each segment is a sequence of records, and each record is followed by its key and value
+     */
+    struct on_disk_record {
+        uint32_t key_size;
+        uint32_t value_size;
+        uint8_t removed;
+    };
+
+    /**
+     * Head object holds the first segment which is not checkpointed, and segments follow it until one doesn't exist
+     */
+    static constexpr std::string_view head_key = "nmfs.metadata_journal";
+
+    std::unique_ptr<kv_backend> backend;
+    std::unordered_map<std::string, journaled_value> journaled_values;
+    std::vector<byte> batch;
+    uint64_t first_segment = 0;
+    uint64_t active_segment = 0;
+    size_t active_segment_size = 0;
+    /**
+     * Held while journaled_values, batch and segment numbers are changed
+     */
+    std::shared_mutex mutex;
+    /**
+     * Held while a batch is written, so batches are appended to a segment in order
+     */
+    std::mutex commit_mutex;
+    /**
+     * Held while a checkpoint runs, as the checkpointer and move may checkpoint at the same time
+     */
+    std::mutex checkpoint_mutex;
+
+    std::mutex checkpointer_mutex;
+    std::condition_variable checkpointer_wakeup;
+    bool stop_checkpointer = false;
+    bool checkpoint_requested = false;
+    std::thread checkpointer;
+
+    [[nodiscard]] std::optional<journaled_value> find(const slice& key);
+    void journal(const slice& key, std::optional<owner_slice> value);
+    /**
+     * Write the batch to the active segment, while commit_mutex is held
+     */
+    void commit();
+    /**
+     * Seal the active segment, and write values of sealed segments to their objects
+     */
+    void checkpoint();
+    void replay();
+    void checkpointer_main();
+    void request_checkpoint();
+    [[nodiscard]] static std::string segment_key(uint64_t segment);
+};
+
+}
+
+#endif //NMFS_KV_BACKENDS_JOURNALED_BACKEND_HPP
@@ -1,8 +1,15 @@
 #ifndef NMFS_KV_BACKENDS_KV_BACKEND_HPP
 #define NMFS_KV_BACKENDS_KV_BACKEND_HPP
 
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "../memory_slices/slice.hpp"
 #include "../memory_slices/owner_slice.hpp"
+#include "exceptions/key_does_not_exist.hpp"
 
 namespace nmfs::kv_backends {
 
@@ -14,14 +21,59 @@ public:
     [[nodiscard]] virtual owner_slice get(const slice& key, size_t length, off_t offset = 0) = 0;
     virtual ssize_t get(const slice& key, slice& value) = 0;
     virtual ssize_t get(const slice& key, off_t offset, size_t length, slice& value) = 0;
+    /**
+     * Read first length bytes of each key concurrently
+     * @return Values in the order of keys, std::nullopt for keys which don't exist
+     */
+    [[nodiscard]] virtual std::vector<std::optional<owner_slice>> get(const std::vector<owner_slice>& keys, size_t length) = 0;
 
     virtual ssize_t put(const slice& key, const slice& value) = 0;
     virtual ssize_t put(const slice& key, off_t offset, const slice& value) = 0;
 
     [[nodiscard]] virtual bool exist(const slice& key) = 0;
     virtual void remove(const slice& key) = 0;
+    /**
+     * Move values to new keys, skipping old keys which don't exist
+     *
+     * Each value is removed from its old key only after it is written to its new key. Backends override this to
+     * copy values without reading them to the client and to move values concurrently.
+     */
+    virtual inline void move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys);
+
+    /**
+     * Set and remove values of the ordered map of an object in one atomic operation, creating the object if needed
+     *
+     * rados_backend stores ordered maps, and the other backends pass them to the backend they wrap.
+     */
+    virtual void update_map(const slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) = 0;
+    /**
+     * List values of the ordered map of an object whose map keys are greater than after
+     * @param values Receives up to max_values values in the order of map keys
+     * @return Whether more values follow, which are listed by passing the last map key as after
+     */
+    virtual bool list_map(const slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) = 0;
+
+    /**
+     * Make every write returned so far durable, for backends which defer writes
+     */
+    virtual inline void sync();
 };
 
+void kv_backend::sync() {
+}
+
+void kv_backend::move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) {
+    for (size_t i = 0; i < old_keys.size(); i++) {
+        try {
+            owner_slice value = get(old_keys[i]);
+            put(new_keys[i], value);
+            remove(old_keys[i]);
+        } catch (exceptions::key_does_not_exist&) {
+            continue;
+        }
+    }
+}
+
 }
 
 #endif //NMFS_KV_BACKENDS_KV_BACKEND_HPP
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <stdexcept>
@@ -159,6 +160,64 @@ ssize_t nmfs::kv_backends::rados_backend::get(const nmfs::slice& key, off_t offs
     return ret;
 }
 
+std::vector<std::optional<nmfs::owner_slice>> nmfs::kv_backends::rados_backend::get(const std::vector<owner_slice>& keys, size_t length) { // batched partial read
+    std::vector<std::optional<owner_slice>> values(keys.size());
+    std::vector<librados::bufferlist> buffer_lists(std::min(keys.size(), max_in_flight_reads));
+    std::vector<librados::AioCompletion*> completions(buffer_lists.size());
+    int error = 0;
+    size_t failed_index = 0;
+
+    // Reads are issued in windows, and every read of a window is waited for before its buffers are reused
+    for (size_t window_begin = 0; window_begin < keys.size(); window_begin += max_in_flight_reads) {
+        size_t window_size = std::min(keys.size() - window_begin, max_in_flight_reads);
+
+        for (size_t i = 0; i < window_size; i++) {
+            auto& value = values[window_begin + i].emplace(length);
+
+            buffer_lists[i] = librados::bufferlist::static_from_mem(value.data(), value.capacity());
+            completions[i] = librados::Rados::aio_create_completion();
+            int ret = io_ctx.aio_read(keys[window_begin + i].to_string(), completions[i], &buffer_lists[i], length, 0);
+            if (ret < 0) {
+                completions[i]->release();
+                completions[i] = nullptr;
+                values[window_begin + i].reset();
+                if (error == 0) {
+                    error = ret;
+                    failed_index = window_begin + i;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < window_size; i++) {
+            if (completions[i] == nullptr) {
+                continue;
+            }
+
+            completions[i]->wait_for_complete();
+            int ret = completions[i]->get_return_value();
+            completions[i]->release();
+
+            if (ret >= 0) {
+                values[window_begin + i]->set_size(ret);
+            } else {
+                values[window_begin + i].reset();
+                if (ret != -ENOENT && error == 0) {
+                    error = ret;
+                    failed_index = window_begin + i;
+                }
+            }
+        }
+
+        if (error != 0) {
+            throw generic_kv_api_failure("rados_backend::get : batched read failed (key = " + keys[failed_index].to_string() + ", size = " + std::to_string(length) + ')', error);
+        }
+    }
+
+    log::information(log_locations::kv_backend_operation)
+        << "rados_backend::get : batched read(number of keys = " << keys.size() << ", size = " << length << ")\n";
+    return values;
+}
+
 ssize_t nmfs::kv_backends::rados_backend::put(const nmfs::slice& key, const nmfs::slice& value) { // fully write
     librados::bufferlist write_buffer = librados::bufferlist::static_from_mem(const_cast<char*>(value.data()), value.size());
     int ret;
@@ -218,3 +277,132 @@ void nmfs::kv_backends::rados_backend::remove(const nmfs::slice& key) {
             throw generic_kv_api_failure("rados_backend::remove : remove failed (key = " + key.to_string() + ')', ret);
     }
 }
+
+void nmfs::kv_backends::rados_backend::move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) {
+    std::vector<librados::AioCompletion*> completions(std::min(old_keys.size(), max_in_flight_moves));
+    std::vector<bool> copied(completions.size());
+    int error = 0;
+    size_t failed_index = 0;
+
+    auto wait = [&](size_t window_begin, size_t window_size, bool copying) {
+        for (size_t i = 0; i < window_size; i++) {
+            if (completions[i] == nullptr) {
+                continue;
+            }
+
+            completions[i]->wait_for_complete();
+            int ret = completions[i]->get_return_value();
+            completions[i]->release();
+            completions[i] = nullptr;
+
+            if (ret >= 0) {
+                copied[i] = copying;
+            } else if (ret != -ENOENT && error == 0) {
+                error = ret;
+                failed_index = window_begin + i;
+            }
+        }
+    };
+
+    // Objects are copied by OSDs in windows, and each old object is removed after its copy is complete
+    for (size_t window_begin = 0; window_begin < old_keys.size(); window_begin += max_in_flight_moves) {
+        size_t window_size = std::min(old_keys.size() - window_begin, max_in_flight_moves);
+        std::vector<librados::ObjectWriteOperation> operations(window_size);
+
+        for (size_t i = 0; i < window_size; i++) {
+            operations[i].copy_from(old_keys[window_begin + i].to_string(), io_ctx, 0, 0);
+            copied[i] = false;
+            completions[i] = librados::Rados::aio_create_completion();
+            int ret = io_ctx.aio_operate(new_keys[window_begin + i].to_string(), completions[i], &operations[i]);
+            if (ret < 0) {
+                completions[i]->release();
+                completions[i] = nullptr;
+                if (error == 0) {
+                    error = ret;
+                    failed_index = window_begin + i;
+                }
+            }
+        }
+        wait(window_begin, window_size, true);
+
+        for (size_t i = 0; i < window_size; i++) {
+            if (!copied[i]) {
+                continue;
+            }
+
+            completions[i] = librados::Rados::aio_create_completion();
+            int ret = io_ctx.aio_remove(old_keys[window_begin + i].to_string(), completions[i]);
+            if (ret < 0) {
+                completions[i]->release();
+                completions[i] = nullptr;
+                if (error == 0) {
+                    error = ret;
+                    failed_index = window_begin + i;
+                }
+            }
+        }
+        wait(window_begin, window_size, false);
+
+        if (error != 0) {
+            throw generic_kv_api_failure("rados_backend::move : move failed (key = " + old_keys[failed_index].to_string() + ')', error);
+        }
+    }
+
+    log::information(log_locations::kv_backend_operation)
+        << "rados_backend::move : copy_from and remove(number of keys = " << old_keys.size() << ")\n";
+}
+
+void nmfs::kv_backends::rados_backend::update_map(const nmfs::slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) {
+    librados::ObjectWriteOperation operation;
+    std::map<std::string, librados::bufferlist> buffer_lists;
+    int ret;
+
+    if (values.empty() && removed_map_keys.empty()) {
+        return;
+    }
+
+    for (const auto& [map_key, value]: values) {
+        buffer_lists.emplace(map_key, librados::bufferlist::static_from_mem(const_cast<char*>(value.data()), value.size()));
+    }
+    if (!buffer_lists.empty()) {
+        operation.omap_set(buffer_lists);
+    }
+    if (!removed_map_keys.empty()) {
+        operation.omap_rm_keys(removed_map_keys);
+    }
+
+    ret = io_ctx.operate(key.to_string(), &operation);
+    if (ret >= 0) {
+        log::information(log_locations::kv_backend_operation)
+            << "rados_backend::update_map : operate(key = " << key.to_string_view() << ", number of values = " << values.size() << ", number of removed keys = " << removed_map_keys.size() << ") = " << ret << "\n";
+    } else if (ret == -ENOENT && values.empty()) {
+        log::debug(log_locations::kv_backend_operation)
+            << "rados_backend::update_map : removing map keys failed (key = " << key.to_string() << ") = -ENOENT\n";
+    } else {
+        throw generic_kv_api_failure("rados_backend::update_map : operate failed (key = " + key.to_string() + ')', ret);
+    }
+}
+
+bool nmfs::kv_backends::rados_backend::list_map(const nmfs::slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) {
+    std::map<std::string, librados::bufferlist> buffer_lists;
+    bool more = false;
+    int ret;
+
+    ret = io_ctx.omap_get_vals2(key.to_string(), std::string(after), max_values, &buffer_lists, &more);
+    if (ret >= 0) {
+        log::information(log_locations::kv_backend_operation)
+            << "rados_backend::list_map : omap_get_vals2(key = " << key.to_string_view() << ", after = " << after << ", max_values = " << max_values << ") = " << buffer_lists.size() << "\n";
+    } else if (ret == -ENOENT) {
+        throw key_does_not_exist(key);
+    } else {
+        throw generic_kv_api_failure("rados_backend::list_map : omap_get_vals2 failed (key = " + key.to_string() + ')', ret);
+    }
+
+    for (auto& [map_key, buffer_list]: buffer_lists) {
+        auto value = owner_slice(buffer_list.length());
+
+        buffer_list.copy(0, buffer_list.length(), value.data());
+        values.emplace(map_key, std::move(value));
+    }
+    return more;
+}
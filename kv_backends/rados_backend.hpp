@@ -22,15 +22,22 @@ public:
     [[nodiscard]] virtual owner_slice get(const slice& key, size_t length, off_t offset) final;
     ssize_t get(const slice& key, slice& value) final; // fully read
     ssize_t get(const slice& key, off_t offset, size_t length, slice& value) final; // partial read
+    [[nodiscard]] std::vector<std::optional<owner_slice>> get(const std::vector<owner_slice>& keys, size_t length) final; // batched partial read
 
     ssize_t put(const slice& key, const slice& value) final; // fully write
     ssize_t put(const slice& key, off_t offset, const slice& value) final; // partial write
 
     [[nodiscard]] bool exist(const slice& key) final;
     void remove(const slice& key) final;
+    void move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) final; // copy_from and remove
+
+    void update_map(const slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) final; // omap_set and omap_rm_keys
+    bool list_map(const slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) final; // omap_get_vals2
 
 private:
     static constexpr const char* pool_name = "cephfs_data";
+    static constexpr size_t max_in_flight_reads = 256;
+    static constexpr size_t max_in_flight_moves = 64;
 
     librados::Rados cluster;
     librados::IoCtx io_ctx;
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <iterator>
+#include "scheduled_backend.hpp"
+#include "../configuration.hpp"
+
+nmfs::kv_backends::scheduled_backend::admission::admission(scheduled_backend& scheduler, size_t slots)
+    : scheduler(scheduler), priority(static_cast<size_t>(io_priority_scope::current())), slots(slots) {
+    auto lock = std::unique_lock(scheduler.mutex);
+    auto& queue = scheduler.waiters[priority];
+    uint64_t ticket = scheduler.next_ticket++;
+    auto since = std::chrono::steady_clock::now();
+    auto starved_at = since + configuration::backend_starvation_duration;
+
+    queue.push_back(waiter {
+        .ticket = ticket,
+        .since = since,
+    });
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        bool first = queue.front().ticket == ticket;
+
+        if (first && scheduler.admissible(priority, slots, now)) {
+            break;
+        } else if (first && now < starved_at) {
+            // Checked again once starved, as nothing may be released meanwhile
+            scheduler.wakeup.wait_until(lock, starved_at);
+        } else {
+            scheduler.wakeup.wait(lock);
+        }
+    }
+
+    queue.pop_front();
+    scheduler.in_flight[priority] += slots;
+    scheduler.total_in_flight += slots;
+    lock.unlock();
+    // Next waiter of the class may be admitted as well
+    scheduler.wakeup.notify_all();
+}
+
+nmfs::kv_backends::scheduled_backend::admission::~admission() {
+    {
+        auto lock = std::unique_lock(scheduler.mutex);
+        scheduler.in_flight[priority] -= slots;
+        scheduler.total_in_flight -= slots;
+    }
+    scheduler.wakeup.notify_all();
+}
+
+nmfs::kv_backends::scheduled_backend::scheduled_backend(std::unique_ptr<kv_backend> backend)
+    : backend(std::move(backend)) {
+}
+
+nmfs::owner_slice nmfs::kv_backends::scheduled_backend::get(const nmfs::slice& key) {
+    auto scheduled = admission(*this);
+    return backend->get(key);
+}
+
+nmfs::owner_slice nmfs::kv_backends::scheduled_backend::get(const nmfs::slice& key, size_t length, off_t offset) {
+    auto scheduled = admission(*this);
+    return backend->get(key, length, offset);
+}
+
+ssize_t nmfs::kv_backends::scheduled_backend::get(const nmfs::slice& key, nmfs::slice& value) { // fully read
+    auto scheduled = admission(*this);
+    return backend->get(key, value);
+}
+
+ssize_t nmfs::kv_backends::scheduled_backend::get(const nmfs::slice& key, off_t offset, size_t length, nmfs::slice& value) { // partial read
+    auto scheduled = admission(*this);
+    return backend->get(key, offset, length, value);
+}
+
+std::vector<std::optional<nmfs::owner_slice>> nmfs::kv_backends::scheduled_backend::get(const std::vector<owner_slice>& keys, size_t length) { // batched partial read
+    size_t chunk_size = batch_size();
+
+    if (keys.size() <= chunk_size) {
+        auto scheduled = admission(*this, keys.size());
+        return backend->get(keys, length);
+    }
+
+    std::vector<std::optional<owner_slice>> values;
+    values.reserve(keys.size());
+    for (size_t begin = 0; begin < keys.size(); begin += chunk_size) {
+        auto chunk = std::vector<owner_slice>(keys.begin() + begin, keys.begin() + std::min(begin + chunk_size, keys.size()));
+        auto scheduled = admission(*this, chunk.size());
+        auto chunk_values = backend->get(chunk, length);
+
+        std::move(chunk_values.begin(), chunk_values.end(), std::back_inserter(values));
+    }
+    return values;
+}
+
+ssize_t nmfs::kv_backends::scheduled_backend::put(const nmfs::slice& key, const nmfs::slice& value) { // fully write
+    auto scheduled = admission(*this);
+    return backend->put(key, value);
+}
+
+ssize_t nmfs::kv_backends::scheduled_backend::put(const nmfs::slice& key, off_t offset, const nmfs::slice& value) { // partial write
+    auto scheduled = admission(*this);
+    return backend->put(key, offset, value);
+}
+
+bool nmfs::kv_backends::scheduled_backend::exist(const nmfs::slice& key) {
+    auto scheduled = admission(*this);
+    return backend->exist(key);
+}
+
+void nmfs::kv_backends::scheduled_backend::remove(const nmfs::slice& key) {
+    auto scheduled = admission(*this);
+    backend->remove(key);
+}
+
+void nmfs::kv_backends::scheduled_backend::move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) {
+    size_t chunk_size = batch_size();
+
+    if (old_keys.size() <= chunk_size) {
+        auto scheduled = admission(*this, old_keys.size());
+        backend->move(old_keys, new_keys);
+        return;
+    }
+
+    for (size_t begin = 0; begin < old_keys.size(); begin += chunk_size) {
+        size_t end = std::min(begin + chunk_size, old_keys.size());
+        auto old_chunk = std::vector<owner_slice>(old_keys.begin() + begin, old_keys.begin() + end);
+        auto new_chunk = std::vector<owner_slice>(new_keys.begin() + begin, new_keys.begin() + end);
+        auto scheduled = admission(*this, old_chunk.size());
+
+        backend->move(old_chunk, new_chunk);
+    }
+}
+
+void nmfs::kv_backends::scheduled_backend::update_map(const nmfs::slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) {
+    auto scheduled = admission(*this);
+    backend->update_map(key, values, removed_map_keys);
+}
+
+bool nmfs::kv_backends::scheduled_backend::list_map(const nmfs::slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) {
+    auto scheduled = admission(*this);
+    return backend->list_map(key, after, max_values, values);
+}
+
+void nmfs::kv_backends::scheduled_backend::sync() {
+    auto scheduled = admission(*this);
+    backend->sync();
+}
+
+bool nmfs::kv_backends::scheduled_backend::admissible(size_t priority, size_t slots, std::chrono::steady_clock::time_point now) const {
+    if (total_in_flight + slots > configuration::backend_max_in_flight || in_flight[priority] + slots > configuration::backend_class_in_flight[priority]) {
+        return false;
+    } else if (now - waiters[priority].front().since >= configuration::backend_starvation_duration) {
+        return true;
+    }
+
+    for (size_t higher_priority = 0; higher_priority < priority; higher_priority++) {
+        if (!waiters[higher_priority].empty() && in_flight[higher_priority] < configuration::backend_class_in_flight[higher_priority]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t nmfs::kv_backends::scheduled_backend::batch_size() {
+    auto priority = static_cast<size_t>(io_priority_scope::current());
+    return std::min(configuration::backend_max_in_flight, configuration::backend_class_in_flight[priority]);
+}
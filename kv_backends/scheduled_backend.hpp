@@ -0,0 +1,89 @@
+#ifndef NMFS_KV_BACKENDS_SCHEDULED_BACKEND_HPP
+#define NMFS_KV_BACKENDS_SCHEDULED_BACKEND_HPP
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "kv_backend.hpp"
+#include "io_priority.hpp"
+
+namespace nmfs::kv_backends {
+
+/**
+ * Backend which admits requests by priority classes of the threads making them
+ *
+ * At most configuration::backend_max_in_flight requests run at once, and at most
+ * configuration::backend_class_in_flight of each class, which leaves room for foreground requests while background
+ * work is running. A request waits while a request of a higher class is waiting and could be admitted, unless it has
+ * waited for configuration::backend_starvation_duration. Requests of a class are admitted in order.
+ *
+ * Batched requests take a slot per key, and are split into chunks no larger than their class may run at once.
+ */
+class scheduled_backend: public kv_backend {
+public:
+    explicit scheduled_backend(std::unique_ptr<kv_backend> backend);
+
+    [[nodiscard]] owner_slice get(const slice& key) final;
+    [[nodiscard]] owner_slice get(const slice& key, size_t length, off_t offset) final;
+    ssize_t get(const slice& key, slice& value) final; // fully read
+    ssize_t get(const slice& key, off_t offset, size_t length, slice& value) final; // partial read
+    [[nodiscard]] std::vector<std::optional<owner_slice>> get(const std::vector<owner_slice>& keys, size_t length) final; // batched partial read
+
+    ssize_t put(const slice& key, const slice& value) final; // fully write
+    ssize_t put(const slice& key, off_t offset, const slice& value) final; // partial write
+
+    [[nodiscard]] bool exist(const slice& key) final;
+    void remove(const slice& key) final;
+    void move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) final;
+
+    void update_map(const slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) final;
+    bool list_map(const slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) final;
+
+    void sync() final;
+
+private:
+    /**
+     * Request admitted while it lives
+     */
+    class admission {
+    public:
+        explicit admission(scheduled_backend& scheduler, size_t slots = 1);
+        admission(const admission&) = delete;
+        ~admission();
+
+    private:
+        scheduled_backend& scheduler;
+        size_t priority;
+        size_t slots;
+    };
+
+    struct waiter {
+        uint64_t ticket;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    std::unique_ptr<kv_backend> backend;
+    std::array<std::deque<waiter>, number_of_io_priorities> waiters;
+    std::array<size_t, number_of_io_priorities> in_flight {};
+    size_t total_in_flight = 0;
+    uint64_t next_ticket = 0;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+
+    /**
+     * Whether the first waiter of a class taking the slots can be admitted now, while the lock is held
+     */
+    [[nodiscard]] bool admissible(size_t priority, size_t slots, std::chrono::steady_clock::time_point now) const;
+    /**
+     * Number of keys of a batch admitted at once for the class of this thread
+     */
+    [[nodiscard]] static size_t batch_size();
+};
+
+}
+
+#endif //NMFS_KV_BACKENDS_SCHEDULED_BACKEND_HPP
@@ -0,0 +1,611 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "write_ahead_log_backend.hpp"
+#include "exceptions/generic_kv_api_failure.hpp"
+#include "exceptions/key_does_not_exist.hpp"
+#include "../configuration.hpp"
+#include "../memory_slices/borrower_slice.hpp"
+#include "../logger/log.hpp"
+
+using namespace nmfs::kv_backends::exceptions;
+
+static constexpr std::string_view segment_prefix = "nmfs.wal.";
+
+nmfs::kv_backends::write_ahead_log_backend::segment_file::segment_file(int descriptor)
+    : descriptor(descriptor) {
+}
+
+nmfs::kv_backends::write_ahead_log_backend::segment_file::~segment_file() {
+    close(descriptor);
+}
+
+nmfs::kv_backends::write_ahead_log_backend::write_ahead_log_backend(std::unique_ptr<kv_backend> backend, std::string_view directory)
+    : backend(std::move(backend)), directory(directory) {
+    recover();
+    active_file = open_segment(active_segment);
+    replayer = std::thread(&write_ahead_log_backend::replayer_main, this);
+}
+
+nmfs::kv_backends::write_ahead_log_backend::~write_ahead_log_backend() {
+    {
+        auto lock = std::unique_lock(mutex);
+        stop_replayer = true;
+    }
+    replayer_wakeup.notify_one();
+    replayer.join();
+
+    // Nothing is left in the log after a clean unmount
+    try {
+        replay();
+        active_file.reset();
+        std::error_code error;
+        std::filesystem::remove(segment_path(active_segment), error);
+    } catch (kv_backend_exception& e) {
+        log::error(log_locations::kv_backend_operation) << "write_ahead_log_backend::replay failed, operations are replayed on next mount: " << e.what() << '\n';
+    }
+}
+
+nmfs::owner_slice nmfs::kv_backends::write_ahead_log_backend::get(const nmfs::slice& key) {
+    auto operations = find(key);
+    if (operations.empty()) {
+        return backend->get(key);
+    }
+
+    auto value = current_value(key, operations);
+    if (!value.has_value()) {
+        throw key_does_not_exist(key);
+    }
+    return std::move(*value);
+}
+
+nmfs::owner_slice nmfs::kv_backends::write_ahead_log_backend::get(const nmfs::slice& key, size_t length, off_t offset) {
+    auto operations = find(key);
+    if (operations.empty()) {
+        return backend->get(key, length, offset);
+    }
+
+    auto value = current_value(key, operations);
+    if (!value.has_value()) {
+        throw key_does_not_exist(key);
+    }
+    size_t begin = std::min(value->size(), static_cast<size_t>(offset));
+    auto result = owner_slice(std::min(length, value->size() - begin));
+    std::copy(value->cbegin() + begin, value->cbegin() + begin + result.size(), result.data());
+    return result;
+}
+
+ssize_t nmfs::kv_backends::write_ahead_log_backend::get(const nmfs::slice& key, nmfs::slice& value) { // fully read
+    auto operations = find(key);
+    if (operations.empty()) {
+        return backend->get(key, value);
+    }
+
+    auto current = current_value(key, operations);
+    if (!current.has_value()) {
+        throw key_does_not_exist(key);
+    } else if (current->size() > value.capacity()) {
+        throw std::out_of_range("write_ahead_log_backend::get : capacity of value slice is not enough");
+    }
+
+    std::copy(current->cbegin(), current->cend(), value.data());
+    value.set_size(current->size());
+    return static_cast<ssize_t>(value.size());
+}
+
+ssize_t nmfs::kv_backends::write_ahead_log_backend::get(const nmfs::slice& key, off_t offset, size_t length, nmfs::slice& value) { // partial read
+    auto operations = find(key);
+    if (operations.empty()) {
+        return backend->get(key, offset, length, value);
+    }
+
+    auto current = current_value(key, operations);
+    if (!current.has_value()) {
+        throw key_does_not_exist(key);
+    } else if (length > value.capacity()) {
+        throw std::out_of_range("write_ahead_log_backend::get : returned object size exceeds capacity of value slice");
+    }
+
+    size_t begin = std::min(current->size(), static_cast<size_t>(offset));
+    size_t size = std::min(length, current->size() - begin);
+    std::copy(current->cbegin() + begin, current->cbegin() + begin + size, value.data());
+    value.set_size(size);
+    return static_cast<ssize_t>(size);
+}
+
+std::vector<std::optional<nmfs::owner_slice>> nmfs::kv_backends::write_ahead_log_backend::get(const std::vector<owner_slice>& keys, size_t length) { // batched partial read
+    auto values = backend->get(keys, length);
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto operations = find(keys[i]);
+        if (operations.empty()) {
+            continue;
+        }
+
+        auto current = current_value(keys[i], operations);
+        if (current.has_value()) {
+            auto& value = values[i].emplace(std::min(length, current->size()));
+            std::copy(current->cbegin(), current->cbegin() + value.size(), value.data());
+        } else {
+            values[i].reset();
+        }
+    }
+    return values;
+}
+
+ssize_t nmfs::kv_backends::write_ahead_log_backend::put(const nmfs::slice& key, const nmfs::slice& value) { // fully write
+    if (value.size() > configuration::write_ahead_log_value_size) {
+        prepare_direct_write(key);
+        return backend->put(key, value);
+    }
+
+    log(operation_type::put, key, 0, owner_slice(value));
+    return 0;
+}
+
+ssize_t nmfs::kv_backends::write_ahead_log_backend::put(const nmfs::slice& key, off_t offset, const nmfs::slice& value) { // partial write
+    if (value.size() > configuration::write_ahead_log_value_size) {
+        prepare_direct_write(key);
+        return backend->put(key, offset, value);
+    }
+
+    log(operation_type::partial_put, key, offset, owner_slice(value));
+    return 0;
+}
+
+bool nmfs::kv_backends::write_ahead_log_backend::exist(const nmfs::slice& key) {
+    auto operations = find(key);
+    if (operations.empty()) {
+        return backend->exist(key);
+    }
+    // A partial write creates the value if it doesn't exist
+    return operations.back()->type != operation_type::remove;
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::remove(const nmfs::slice& key) {
+    log(operation_type::remove, key, 0, std::nullopt);
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) {
+    bool logged = std::any_of(old_keys.cbegin(), old_keys.cend(), [this](const owner_slice& key) {
+        return !find(key).empty();
+    }) || std::any_of(new_keys.cbegin(), new_keys.cend(), [this](const owner_slice& key) {
+        return !find(key).empty();
+    });
+
+    // Values are copied inside the backend, so they are written there first
+    if (logged) {
+        replay();
+    } else {
+        sync();
+    }
+    backend->move(old_keys, new_keys);
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::update_map(const nmfs::slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) {
+    // An ordered map is removed with its object, so a logged removal is replayed before the map is changed. Otherwise
+    // operations logged before are made durable, so none of them is lost while a later change of a map survives a crash
+    if (!find(key).empty()) {
+        replay();
+    } else {
+        sync();
+    }
+    backend->update_map(key, values, removed_map_keys);
+}
+
+bool nmfs::kv_backends::write_ahead_log_backend::list_map(const nmfs::slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) {
+    if (!find(key).empty()) {
+        replay();
+    }
+    return backend->list_map(key, after, max_values, values);
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::sync() {
+    std::shared_ptr<segment_file> file;
+    uint64_t count;
+    {
+        // Sealed segments are written to the local device when they are sealed
+        auto lock = std::unique_lock(mutex);
+        if (synced_count >= logged_count) {
+            return;
+        }
+        file = active_file;
+        count = logged_count;
+    }
+
+    if (fdatasync(file->descriptor) < 0) {
+        throw generic_kv_api_failure("write_ahead_log_backend::sync : fdatasync failed", -errno);
+    }
+
+    auto lock = std::unique_lock(mutex);
+    synced_count = std::max(synced_count, count);
+}
+
+std::vector<std::shared_ptr<const nmfs::kv_backends::write_ahead_log_backend::operation>> nmfs::kv_backends::write_ahead_log_backend::find(const nmfs::slice& key) {
+    auto lock = std::unique_lock(mutex);
+    auto iterator = operations_of_keys.find(key.to_string());
+
+    if (iterator != operations_of_keys.end()) {
+        return iterator->second;
+    } else {
+        return {};
+    }
+}
+
+std::optional<nmfs::owner_slice> nmfs::kv_backends::write_ahead_log_backend::current_value(const nmfs::slice& key, const std::vector<std::shared_ptr<const operation>>& operations) {
+    std::string key_string = key.to_string();
+    auto first_partial = operations.cbegin();
+    std::optional<owner_slice> base;
+    bool merged_found = false;
+
+    {
+        // Operations up to the last one merged before are applied already
+        auto lock = std::unique_lock(mutex);
+        auto merged = merged_values.find(key_string);
+        if (merged != merged_values.end()) {
+            auto last_merged = std::find(operations.cbegin(), operations.cend(), merged->second.last);
+            if (last_merged != operations.cend()) {
+                first_partial = last_merged + 1;
+                base.emplace(merged->second.value);
+                merged_found = true;
+            }
+        }
+    }
+
+    auto last_whole = std::find_if(operations.crbegin(), std::make_reverse_iterator(first_partial), [](const auto& operation) {
+        return operation->type != operation_type::partial_put;
+    });
+    if (last_whole != std::make_reverse_iterator(first_partial)) {
+        base.reset();
+        if ((*last_whole)->type == operation_type::put) {
+            base.emplace(*(*last_whole)->value);
+        }
+        first_partial = last_whole.base();
+    } else if (!merged_found) {
+        // Partial writes overwrite the same bytes again if some of them are replayed while the value is read
+        try {
+            base.emplace(backend->get(key));
+        } catch (key_does_not_exist&) {
+        }
+    }
+    if (first_partial == operations.cend()) {
+        return base;
+    }
+
+    size_t size = base.has_value() ? base->size() : 0;
+    for (auto iterator = first_partial; iterator != operations.cend(); iterator++) {
+        size = std::max(size, static_cast<size_t>((*iterator)->offset) + (*iterator)->value->size());
+    }
+
+    auto value = owner_slice(size);
+    std::fill(value.begin(), value.end(), 0);
+    if (base.has_value()) {
+        std::copy(base->cbegin(), base->cend(), value.data());
+    }
+    for (auto iterator = first_partial; iterator != operations.cend(); iterator++) {
+        const operation& partial_put = **iterator;
+        std::copy(partial_put.value->cbegin(), partial_put.value->cend(), value.data() + partial_put.offset);
+    }
+
+    {
+        // Kept while the key has logged operations, so next reads apply only operations logged after them
+        auto lock = std::unique_lock(mutex);
+        if (operations_of_keys.contains(key_string)) {
+            merged_values.insert_or_assign(std::move(key_string), merged_value {
+                .last = operations.back(),
+                .value = value,
+            });
+        }
+    }
+    return value;
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::log(operation_type type, const nmfs::slice& key, off_t offset, std::optional<owner_slice> value) {
+    on_disk_record record;
+    std::memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.key_size = static_cast<uint32_t>(key.size());
+    record.value_size = static_cast<uint32_t>(value.has_value() ? value->size() : 0);
+    record.offset = static_cast<uint64_t>(offset);
+    record.checksum = checksum(record, key.data(), value.has_value() ? value->data() : nullptr);
+
+    std::vector<byte> bytes;
+    auto record_bytes = reinterpret_cast<const byte*>(&record);
+    bytes.reserve(sizeof(record) + record.key_size + record.value_size);
+    bytes.insert(bytes.end(), record_bytes, record_bytes + sizeof(record));
+    bytes.insert(bytes.end(), key.cbegin(), key.cend());
+    if (value.has_value()) {
+        bytes.insert(bytes.end(), value->cbegin(), value->cend());
+    }
+
+    auto logged = std::make_shared<const operation>(operation {
+        .type = type,
+        .key = key.to_string(),
+        .offset = offset,
+        .value = std::move(value),
+        .record_size = bytes.size(),
+    });
+    auto lock = std::unique_lock(mutex);
+
+    if (logged_size >= configuration::write_ahead_log_size) {
+        replayer_wakeup.notify_one();
+        replayed.wait(lock, [this]() {
+            return logged_size < configuration::write_ahead_log_size;
+        });
+    }
+
+    // Records are appended while the lock is held, so they are in the order of logged_operations
+    off_t append_offset = lseek(active_file->descriptor, 0, SEEK_END);
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t ret = write(active_file->descriptor, bytes.data() + written, bytes.size() - written);
+        if (ret < 0 && errno != EINTR) {
+            int error = errno;
+            std::string message = "write_ahead_log_backend::log : write failed (key = " + logged->key + ", segment = " + std::to_string(active_segment) + ')';
+            discard_torn_append(append_offset);
+            throw generic_kv_api_failure(message, -error);
+        } else if (ret > 0) {
+            written += ret;
+        }
+    }
+
+    logged_operations.push_back(logged);
+    operations_of_keys[logged->key].push_back(logged);
+    logged_size += logged->record_size;
+    logged_count++;
+    if (logged_size >= configuration::write_ahead_log_batch_size) {
+        replayer_wakeup.notify_one();
+    }
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::discard_torn_append(off_t append_offset) {
+    // recover stops reading a segment at a torn record, so records appended after it would be lost
+    if (append_offset >= 0 && ftruncate(active_file->descriptor, append_offset) == 0) {
+        return;
+    }
+
+    // Records before the torn one are written to the device before the segment is sealed, as replay does
+    if (fdatasync(active_file->descriptor) < 0) {
+        log::error(log_locations::kv_backend_operation)
+            << "write_ahead_log_backend::log : segment with a torn record can't be sealed (segment = " << active_segment << ")\n";
+        return;
+    }
+    try {
+        active_file = open_segment(active_segment + 1);
+    } catch (generic_kv_api_failure& e) {
+        log::error(log_locations::kv_backend_operation) << e.what() << '\n';
+        return;
+    }
+    synced_count = logged_count;
+    active_segment++;
+    log::warning(log_locations::kv_backend_operation)
+        << "write_ahead_log_backend::log : segment with a torn record sealed (next segment = " << active_segment << ")\n";
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::prepare_direct_write(const nmfs::slice& key) {
+    // A logged operation of the key replayed later would overwrite the value
+    if (!find(key).empty()) {
+        replay();
+    } else {
+        sync();
+    }
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::replay() {
+    auto replay_lock = std::unique_lock(replay_mutex);
+    std::vector<std::shared_ptr<const operation>> operations;
+    uint64_t last_sealed_segment;
+
+    {
+        // Operations are logged to the next segment while sealed ones are replayed
+        auto lock = std::unique_lock(mutex);
+        if (logged_operations.empty()) {
+            return;
+        }
+
+        if (fdatasync(active_file->descriptor) < 0) {
+            throw generic_kv_api_failure("write_ahead_log_backend::replay : fdatasync failed (segment = " + std::to_string(active_segment) + ')', -errno);
+        }
+        synced_count = logged_count;
+        active_file = open_segment(active_segment + 1);
+        last_sealed_segment = active_segment++;
+        operations.assign(logged_operations.cbegin(), logged_operations.cend());
+    }
+
+    apply(operations);
+    backend->sync();
+
+    {
+        auto lock = std::unique_lock(mutex);
+        logged_operations.erase(logged_operations.begin(), logged_operations.begin() + static_cast<ptrdiff_t>(operations.size()));
+
+        std::unordered_map<std::string_view, size_t> replayed_of_keys;
+        for (const auto& replayed_operation: operations) {
+            replayed_of_keys[replayed_operation->key]++;
+            logged_size -= replayed_operation->record_size;
+        }
+        for (const auto& [key, count]: replayed_of_keys) {
+            merged_values.erase(std::string(key));
+            auto iterator = operations_of_keys.find(std::string(key));
+            if (iterator->second.size() == count) {
+                operations_of_keys.erase(iterator);
+            } else {
+                iterator->second.erase(iterator->second.begin(), iterator->second.begin() + static_cast<ptrdiff_t>(count));
+            }
+        }
+    }
+    replayed.notify_all();
+
+    // Segments left behind are replayed again on next mount, which only writes the same values again
+    for (uint64_t segment = first_segment; segment <= last_sealed_segment; segment++) {
+        std::error_code error;
+        std::filesystem::remove(segment_path(segment), error);
+    }
+    first_segment = last_sealed_segment + 1;
+    log::information(log_locations::kv_backend_operation)
+        << "write_ahead_log_backend::replay : (number of operations = " << operations.size() << ", next segment = " << first_segment << ")\n";
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::apply(const std::vector<std::shared_ptr<const operation>>& operations) {
+    // Operations before the last whole write or removal of their key are overwritten by it
+    std::unordered_map<std::string_view, size_t> last_whole_of_keys;
+    for (size_t i = 0; i < operations.size(); i++) {
+        if (operations[i]->type != operation_type::partial_put) {
+            last_whole_of_keys[operations[i]->key] = i;
+        }
+    }
+
+    for (size_t i = 0; i < operations.size(); i++) {
+        const operation& operation = *operations[i];
+        auto last_whole = last_whole_of_keys.find(operation.key);
+        if (last_whole != last_whole_of_keys.end() && i < last_whole->second) {
+            continue;
+        }
+
+        DECLARE_CONST_BORROWER_SLICE(key, operation.key.data(), operation.key.size());
+        switch (operation.type) {
+            case operation_type::put:
+                backend->put(key, *operation.value);
+                break;
+            case operation_type::partial_put:
+                backend->put(key, operation.offset, *operation.value);
+                break;
+            case operation_type::remove:
+                backend->remove(key);
+                break;
+        }
+    }
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::recover() {
+    std::vector<uint64_t> segments;
+
+    std::filesystem::create_directories(directory);
+    for (const auto& file: std::filesystem::directory_iterator(directory)) {
+        std::string name = file.path().filename().string();
+        uint64_t segment;
+
+        if (!name.starts_with(segment_prefix)) {
+            continue;
+        }
+        auto [end, error] = std::from_chars(name.data() + segment_prefix.size(), name.data() + name.size(), segment);
+        if (error == std::errc() && end == name.data() + name.size()) {
+            segments.push_back(segment);
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+
+    for (uint64_t segment: segments) {
+        auto stream = std::ifstream(segment_path(segment), std::ios::binary);
+        std::vector<byte> records((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        std::vector<std::shared_ptr<const operation>> operations;
+
+        // Only the tail of a segment may be torn, as a failed append is cut back or ends its segment
+        size_t position = 0;
+        while (position + sizeof(on_disk_record) <= records.size()) {
+            on_disk_record record;
+            std::memcpy(&record, records.data() + position, sizeof(record));
+            const byte* key = records.data() + position + sizeof(record);
+            const byte* value = key + record.key_size;
+
+            if (position + sizeof(record) + record.key_size + record.value_size > records.size() || checksum(record, key, value) != record.checksum) {
+                log::warning(log_locations::kv_backend_operation)
+                    << "write_ahead_log_backend::recover : torn record ignored (segment = " << segment << ", offset = " << position << ")\n";
+                break;
+            }
+
+            std::optional<owner_slice> record_value;
+            if (record.type != operation_type::remove) {
+                record_value.emplace(record.value_size);
+                std::copy(value, value + record.value_size, record_value->data());
+            }
+            operations.push_back(std::make_shared<const operation>(operation {
+                .type = record.type,
+                .key = std::string(reinterpret_cast<const char*>(key), record.key_size),
+                .offset = static_cast<off_t>(record.offset),
+                .value = std::move(record_value),
+                .record_size = sizeof(record) + record.key_size + record.value_size,
+            }));
+            position += sizeof(record) + record.key_size + record.value_size;
+        }
+
+        apply(operations);
+        log::information(log_locations::kv_backend_operation)
+            << "write_ahead_log_backend::recover : (segment = " << segment << ", number of operations = " << operations.size() << ")\n";
+    }
+
+    if (!segments.empty()) {
+        backend->sync();
+        for (uint64_t segment: segments) {
+            std::error_code error;
+            std::filesystem::remove(segment_path(segment), error);
+        }
+        first_segment = active_segment = segments.back() + 1;
+    }
+}
+
+void nmfs::kv_backends::write_ahead_log_backend::replayer_main() {
+    auto lock = std::unique_lock(mutex);
+
+    while (true) {
+        replayer_wakeup.wait_for(lock, configuration::write_ahead_log_replay_interval, [this]() {
+            return stop_replayer || logged_size >= configuration::write_ahead_log_batch_size;
+        });
+        if (stop_replayer) {
+            return;
+        } else if (logged_operations.empty()) {
+            continue;
+        }
+        lock.unlock();
+
+        try {
+            replay();
+        } catch (kv_backend_exception& e) {
+            // Operations stay logged, and are replayed with sealed segments next time
+            log::error(log_locations::kv_backend_operation) << "write_ahead_log_backend::replay failed: " << e.what() << '\n';
+        }
+        lock.lock();
+    }
+}
+
+std::shared_ptr<nmfs::kv_backends::write_ahead_log_backend::segment_file> nmfs::kv_backends::write_ahead_log_backend::open_segment(uint64_t segment) {
+    int descriptor = open(segment_path(segment).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+
+    if (descriptor < 0) {
+        throw generic_kv_api_failure("write_ahead_log_backend::open_segment : open failed (segment = " + std::to_string(segment) + ')', -errno);
+    }
+    return std::make_shared<segment_file>(descriptor);
+}
+
+std::string nmfs::kv_backends::write_ahead_log_backend::segment_path(uint64_t segment) const {
+    return directory + '/' + std::string(segment_prefix) + std::to_string(segment);
+}
+
+uint32_t nmfs::kv_backends::write_ahead_log_backend::checksum(const on_disk_record& record, const byte* key, const byte* value) {
+    // FNV-1a over the record with its checksum cleared, its key and value
+    uint32_t hash = 2166136261u;
+    auto update = [&hash](const byte* begin, const byte* end) {
+        for (const byte* current = begin; current < end; current++) {
+            hash = (hash ^ static_cast<uint8_t>(*current)) * 16777619u;
+        }
+    };
+
+    on_disk_record cleared;
+    std::memcpy(&cleared, &record, sizeof(cleared));
+    cleared.checksum = 0;
+    auto cleared_bytes = reinterpret_cast<const byte*>(&cleared);
+    update(cleared_bytes, cleared_bytes + sizeof(cleared));
+    update(key, key + record.key_size);
+    if (value != nullptr) {
+        update(value, value + record.value_size);
+    }
+    return hash;
+}
@@ -0,0 +1,179 @@
+#ifndef NMFS_KV_BACKENDS_WRITE_AHEAD_LOG_BACKEND_HPP
+#define NMFS_KV_BACKENDS_WRITE_AHEAD_LOG_BACKEND_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "kv_backend.hpp"
+
+namespace nmfs::kv_backends {
+
+/**
+ * Backend which logs writes to files on a local device and replays them to another backend in the background
+ *
+ * Puts and removes are appended to the active segment of the log, so sync waits only for the local device. A
+ * background thread seals the active segment every configuration::write_ahead_log_replay_interval, or once logged
+ * operations grow over configuration::write_ahead_log_batch_size, replays sealed segments to the backend in log order
+ * skipping values overwritten later in the same batch, syncs the backend and removes them. Writes wait while logged
+ * operations are over configuration::write_ahead_log_size.
+ *
+ * Values over configuration::write_ahead_log_value_size, such as data objects, are written to the backend directly
+ * after the log is written to the local device, or replayed if their key has logged operations. So the log serializes
+ * only small writes, and the backend never holds a value older than the log does.
+ *
+ * Values with logged operations are served by applying them over the value of the backend, which is kept merged until
+ * they are replayed, and segments left by a crash are replayed on construction. Ordered maps and moves of keys with
+ * logged operations wait for every logged operation to be replayed.
+ */
+class write_ahead_log_backend: public kv_backend {
+public:
+    /**
+     * @param directory Directory on a local device holding segments of the log, created if needed
+     */
+    write_ahead_log_backend(std::unique_ptr<kv_backend> backend, std::string_view directory);
+    ~write_ahead_log_backend() override;
+
+    [[nodiscard]] owner_slice get(const slice& key) final;
+    [[nodiscard]] owner_slice get(const slice& key, size_t length, off_t offset) final;
+    ssize_t get(const slice& key, slice& value) final; // fully read
+    ssize_t get(const slice& key, off_t offset, size_t length, slice& value) final; // partial read
+    [[nodiscard]] std::vector<std::optional<owner_slice>> get(const std::vector<owner_slice>& keys, size_t length) final; // batched partial read
+
+    ssize_t put(const slice& key, const slice& value) final; // fully write
+    ssize_t put(const slice& key, off_t offset, const slice& value) final; // partial write
+
+    [[nodiscard]] bool exist(const slice& key) final;
+    void remove(const slice& key) final;
+    void move(const std::vector<owner_slice>& old_keys, const std::vector<owner_slice>& new_keys) final;
+
+    void update_map(const slice& key, const std::map<std::string, owner_slice>& values, const std::set<std::string>& removed_map_keys) final;
+    bool list_map(const slice& key, std::string_view after, size_t max_values, std::map<std::string, owner_slice>& values) final;
+
+    /**
+     * Write the active segment to the local device
+     */
+    void sync() final;
+
+private:
+    enum class operation_type: uint8_t {
+        put,
+        partial_put,
+        remove,
+    };
+
+    struct operation {
+        operation_type type;
+        std::string key;
+        off_t offset;
+        std::optional<owner_slice> value;
+        size_t record_size;
+    };
+
+    /**
+     * Each segment is a sequence of records, and each record is followed by its key and value
+     */
+    struct on_disk_record {
+        /**
+         * Checksum of the rest of the record, its key and value, so a record torn by a crash is detected
+         */
+        uint32_t checksum;
+        operation_type type;
+        uint32_t key_size;
+        uint32_t value_size;
+        uint64_t offset;
+    };
+
+    /**
+     * Value of a key with every logged operation applied up to the last one
+     */
+    struct merged_value {
+        std::shared_ptr<const operation> last;
+        owner_slice value;
+    };
+
+    /**
+     * File descriptor of a segment, closed when it is neither active nor synced
+     */
+    struct segment_file {
+        int descriptor;
+
+        explicit segment_file(int descriptor);
+        segment_file(const segment_file&) = delete;
+        ~segment_file();
+    };
+
+    std::unique_ptr<kv_backend> backend;
+    std::string directory;
+    /**
+     * Operations not replayed yet in log order, and the same operations of each key
+     */
+    std::deque<std::shared_ptr<const operation>> logged_operations;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<const operation>>> operations_of_keys;
+    /**
+     * Values read from keys with logged operations, dropped when they are replayed
+     */
+    std::unordered_map<std::string, merged_value> merged_values;
+    size_t logged_size = 0;
+    /**
+     * Number of operations logged, and of them written to the local device
+     */
+    uint64_t logged_count = 0;
+    uint64_t synced_count = 0;
+    uint64_t first_segment = 0;
+    uint64_t active_segment = 0;
+    std::shared_ptr<segment_file> active_file;
+    /**
+     * Held while operations are logged, and while the active segment is sealed
+     */
+    std::mutex mutex;
+    /**
+     * Notified when logged operations are replayed
+     */
+    std::condition_variable replayed;
+    /**
+     * Held while sealed segments are replayed, so they are replayed in order
+     */
+    std::mutex replay_mutex;
+
+    std::condition_variable replayer_wakeup;
+    bool stop_replayer = false;
+    std::thread replayer;
+
+    [[nodiscard]] std::vector<std::shared_ptr<const operation>> find(const slice& key);
+    /**
+     * Apply logged operations of a key over its value in the backend
+     * @return Current value, or std::nullopt if the key doesn't exist
+     */
+    [[nodiscard]] std::optional<owner_slice> current_value(const slice& key, const std::vector<std::shared_ptr<const operation>>& operations);
+    void log(operation_type type, const slice& key, off_t offset, std::optional<owner_slice> value);
+    /**
+     * Cut the active segment back to the size before a failed append, or seal it if it can't be, with mutex held
+     */
+    void discard_torn_append(off_t append_offset);
+    /**
+     * Make operations logged before durable ahead of a value written to the backend directly
+     */
+    void prepare_direct_write(const slice& key);
+    /**
+     * Seal the active segment, and replay every sealed segment to the backend
+     */
+    void replay();
+    void apply(const std::vector<std::shared_ptr<const operation>>& operations);
+    void recover();
+    void replayer_main();
+    [[nodiscard]] std::shared_ptr<segment_file> open_segment(uint64_t segment);
+    [[nodiscard]] std::string segment_path(uint64_t segment) const;
+    [[nodiscard]] static uint32_t checksum(const on_disk_record& record, const byte* key, const byte* value);
+};
+
+}
+
+#endif //NMFS_KV_BACKENDS_WRITE_AHEAD_LOG_BACKEND_HPP
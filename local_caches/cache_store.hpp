@@ -1,16 +1,23 @@
 #ifndef NMFS_LOCAL_CACHES_CACHE_STORE_HPP
 #define NMFS_LOCAL_CACHES_CACHE_STORE_HPP
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
-#include <map>
 #include <mutex>
 #include <optional>
+#include <queue>
 #include <shared_mutex>
+#include <string>
 #include <string_view>
 #include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include <sys/stat.h>
 #include <stdexcept>
 #include "../structures/directory.hpp"
@@ -20,6 +27,12 @@
 #include "../memory_slices/borrower_slice.hpp"
 #include "utils/open_context.hpp"
 #include "utils/directory_open_context.hpp"
+#include "utils/dirty_throttle.hpp"
+#include "utils/path_trie.hpp"
+#include "utils/rename_journal.hpp"
+#include "utils/sync_barrier.hpp"
+#include "utils/work_queue.hpp"
+#include "negative_cache.hpp"
 #include "../kv_backends/exceptions/key_does_not_exist.hpp"
 #include "../exceptions/file_does_not_exist.hpp"
 #include "../exceptions/file_already_exists.hpp"
@@ -32,6 +45,8 @@ class cache_store {
 public:
     using directory_entry_type = typename indexing::directory_entry_type;
     using metadata_type = typename indexing::metadata_type;
+    using metadata_map = std::unordered_map<path_node*, metadata_type>;
+    using directory_map = std::unordered_map<path_node*, directory<indexing>>;
 
     explicit cache_store(super_object<indexing>& context);
     ~cache_store();
@@ -40,39 +55,275 @@ public:
     inline open_context<indexing, lock_type> open(std::string_view path);
     template<template<typename> typename lock_type>
     inline open_context<indexing, lock_type> create(std::string_view path, uid_t owner, gid_t group, mode_t mode);
-    inline std::optional<typename std::map<std::string, metadata_type, std::less<>>::iterator> drop_if_policy_requires(std::string_view path, metadata<indexing>& metadata);
+    inline std::optional<typename metadata_map::iterator> drop_if_policy_requires(std::string_view path, metadata<indexing>& metadata);
     template<template<typename> typename lock_type>
     inline void remove(open_context<indexing, lock_type> open_context);
     inline void move(std::string_view old_path, std::string_view new_path);
+    /**
+     * Type of the file, taken from its cached metadata if there is one instead of looking up its parent directory
+     */
     inline mode_t get_type(std::string_view path);
+    /**
+     * Check whether the path was recently looked up and found not to exist
+     */
+    [[nodiscard]] inline bool is_known_nonexistent(std::string_view path) const;
+    /**
+     * Generation to be passed to remember_nonexistent, taken before the lookup which didn't find the path
+     */
+    [[nodiscard]] inline uint64_t nonexistent_generation() const;
+    /**
+     * Remember the path as nonexistent, unless a path was created since the generation was taken
+     */
+    inline void remember_nonexistent(std::string_view path, uint64_t generation);
+    /**
+     * Forget the path as nonexistent, which is called once its entry is added to its parent directory
+     */
+    inline void forget_nonexistent(std::string_view path);
+    [[nodiscard]] inline std::chrono::system_clock::duration negative_valid_duration() const;
 
     template<template<typename> typename lock_type>
     inline directory_open_context<indexing, lock_type> open_directory(std::string_view path);
+    /**
+     * Open metadata of a directory without constructing the directory, so its entries are not loaded
+     */
+    template<template<typename> typename lock_type>
+    inline open_context<indexing, lock_type> open_directory_metadata(std::string_view path);
     template<template<typename> typename lock_type>
     inline directory_open_context<indexing, lock_type> create_directory(std::string_view path, uid_t owner, gid_t group, mode_t mode);
-    inline std::optional<typename std::map<std::string, directory<indexing>, std::less<>>::iterator> drop_if_policy_requires(std::string_view path, directory<indexing>& directory);
+    inline std::optional<typename directory_map::iterator> drop_if_policy_requires(std::string_view path, directory<indexing>& directory);
     template<template<typename> typename lock_type>
     inline void remove_directory(directory_open_context<indexing, lock_type> directory_open_context);
+    /**
+     * Move a directory and every entry under it
+     *
+     * Entries are moved concurrently by a bounded number of threads, and each directory is moved after entries under
+     * it, writing new objects before removing old ones. The rename is kept in a journal until finish_rename is called,
+     * so resume_renames completes it if it is interrupted by a crash.
+     */
     inline void move_directory(std::string_view old_path, std::string_view new_path);
+    /**
+     * Forget a directory rename after entries of its parents are written
+     */
+    inline void finish_rename(std::string_view old_path);
+    /**
+     * Complete directory renames interrupted by a crash, on mount
+     */
+    inline void resume_renames();
+    /**
+     * Attributes of listed entries of a directory for READDIRPLUS
+     *
+     * Metadata not in the cache is read from the backend in one batch and cached. An entry is std::nullopt if its
+     * metadata is busy, stale or missing, so the kernel looks it up later instead.
+     * @return Attributes in the order of entries
+     */
+    inline std::vector<std::optional<struct stat>> stat_entries(std::string_view path, const std::vector<typename directory<indexing>::listed_entry>& entries);
 
-    inline void flush_all() const;
+    inline void flush_all();
+    /**
+     * Make data and metadata of a file durable, while a lock of its metadata is held
+     *
+     * Data is written through, so dirty metadata and attributes queued for its directory entry are written. Backend
+     * syncs of concurrent calls are coalesced, so each call waits for at most one sync started after it.
+     */
+    inline void sync(std::string_view path, const metadata<indexing>& metadata);
+    /**
+     * Make entries and metadata of a directory durable
+     */
+    inline void sync(const directory<indexing>& directory);
+    /**
+     * Register dirty entries to be written by the background worker
+     *
+     * Entries are registered once when they become dirty, so flushing costs O(dirty) rather than O(cached). A directory is
+     * charged with its header record, and with bytes of changed records as they change.
+     */
+    inline void mark_dirty(metadata<indexing>& metadata);
+    inline void mark_dirty(directory<indexing>& directory, size_t bytes = 0);
+    /**
+     * Delay a writer while dirty entries are over their soft limits, and start flushing them early
+     *
+     * It is called before an operation which makes entries dirty, without holding any lock.
+     */
+    inline void balance_dirty();
+    /**
+     * Queue an entry to replace the entry of path in its parent directory
+     *
+     * Indexing types keeping attributes in directory entries call this on flush. The parent directory can't be
+     * locked while flushing, so the background worker applies queued entries before flushing directories.
+     */
+    inline void update_entry(std::string_view path, directory_entry_type entry);
+    /**
+     * Entry of path queued by update_entry and not applied to its parent directory yet
+     */
+    [[nodiscard]] inline std::optional<directory_entry_type> pending_entry(std::string_view path);
+    /**
+     * Queue data objects of a deleted or truncated file to be removed by the reclaimer
+     *
+     * Removals run in the reclamation class, so unlink and truncate return once metadata is updated.
+     */
+    inline void reclaim(const slice& key, uint32_t index_from, uint32_t index_to);
+    /**
+     * Wait until data objects of the key queued by reclaim are removed, before they are used again
+     */
+    inline void wait_for_reclamation(const slice& key);
 
 private:
     super_object<indexing>& context;
-    std::map<std::string, metadata_type, std::less<>> cache;
+    caching_policy policy;
+    path_trie paths;
+    negative_cache negative_entries;
+    metadata_map cache;
     std::shared_mutex cache_mutex;
-    std::map<std::string, directory<indexing>, std::less<>> directory_cache;
+    directory_map directory_cache;
     std::shared_mutex directory_cache_mutex;
-    std::thread background_worker;
+    /**
+     * Dirty entries with bytes charged to dirty_throttle for each of them
+     */
+    std::unordered_map<metadata<indexing>*, size_t> dirty_metadata;
+    std::unordered_map<directory<indexing>*, size_t> dirty_directories;
+    /**
+     * Time the oldest entry dirty since the last flush became dirty
+     */
+    std::optional<std::chrono::system_clock::time_point> oldest_dirty;
+    std::mutex dirty_mutex;
+    std::unordered_map<std::string, directory_entry_type> pending_entries;
+    std::mutex pending_entries_mutex;
+    dirty_throttle throttle;
+    sync_barrier backend_sync;
+    rename_journal renames;
+    work_queue rename_queue;
+    work_queue flush_queue;
+    /**
+     * Held during a pass of flushes, so passes of the background worker and flush_all never run tasks of each other
+     * while holding locks of caches
+     */
+    std::mutex flush_mutex;
+
+    /**
+     * Number of entries moved by a directory rename, which is reported every configuration::rename_progress_interval
+     */
+    struct rename_progress {
+        std::string_view path;
+        std::atomic<size_t> moved_entries = 0;
+    };
+
+    /**
+     * Closed entries to be checked against caching policy at deadline
+     *
+     * Each entry holds a reference of its path_node. As every close schedules one, an entry whose deadline has
+     * passed while it is kept by the policy doesn't need to be rescheduled.
+     */
+    struct expiration {
+        std::chrono::system_clock::time_point deadline;
+        path_node* node;
+
+        constexpr bool operator>(const expiration& other) const;
+    };
+    std::priority_queue<expiration, std::vector<expiration>, std::greater<>> expirations;
+    std::mutex expiration_mutex;
+    std::mutex background_worker_mutex;
+    std::condition_variable background_worker_wakeup;
     bool stop_background_worker = false;
+    bool eviction_requested = false;
+    bool flush_requested = false;
+    /**
+     * Set when an entry becomes dirty while nothing was, so the background worker schedules its flush
+     */
+    bool flush_rescheduled = false;
+    std::thread background_worker;
+
+    /**
+     * Data objects of a file from index_from to index_to, queued for removal
+     */
+    struct reclamation {
+        owner_slice key;
+        uint32_t index_from;
+        uint32_t index_to;
+    };
+    std::deque<reclamation> reclamations;
+    /**
+     * Number of reclamations of each key queued or running, and of all keys, which is read without the lock
+     */
+    std::unordered_map<std::string, size_t> reclaiming_keys;
+    std::atomic<size_t> number_of_reclamations = 0;
+    std::mutex reclamation_mutex;
+    std::condition_variable reclaimer_wakeup;
+    /**
+     * Notified when a reclamation is finished
+     */
+    std::condition_variable reclaimed;
+    bool stop_reclaimer = false;
+    std::thread reclaimer;
 
-    template<typename slice_type>
-    inline typename std::map<std::string, metadata_type, std::less<>>::iterator open(std::string_view path, std::function<slice_type(super_object<indexing>&, std::string_view)> key_generator);
+    /**
+     * Find or load metadata, whose open count is increased before the cache is unlocked
+     */
+    inline metadata_type& open(std::string_view path, std::function<metadata_type(super_object<indexing>&, std::string_view)> loader);
+    template<typename map_type>
+    inline typename map_type::iterator find_in(map_type& map, std::string_view path);
+    template<typename map_type, typename... argument_types>
+    inline typename map_type::iterator emplace_in(map_type& map, std::string_view path, argument_types&&... arguments);
+    template<typename map_type>
+    inline typename map_type::iterator erase_from(map_type& map, typename map_type::iterator iterator);
+    inline void track(metadata_type& metadata);
+    inline void track(directory<indexing>& directory);
+    inline void untrack(metadata_type& metadata);
+    inline void untrack(directory<indexing>& directory);
+    inline void schedule_expiration(std::string_view path, const metadata<indexing>& metadata);
+    /**
+     * Move cached entries of old_path and paths under it to new_path, for indexing types whose keys don't depend
+     * on paths
+     *
+     * Only the node of old_path is moved in paths, so entries keep their keys and addresses, and open file handles
+     * stay valid. No backend operation is needed.
+     */
+    inline void rename_cached(std::string_view old_path, std::string_view new_path);
+    /**
+     * Move entries of a directory in parallel, and then the directory, skipping entries already moved
+     */
+    inline void move_subtree(std::string_view old_path, std::string_view new_path, rename_progress& progress);
+    /**
+     * Make parents of an interrupted rename list the directory under new_path only
+     */
+    inline void restore_parent_entries(std::string_view old_path, std::string_view new_path);
+    template<typename map_type>
+    inline void drop_cached(map_type& map, std::string_view path);
     inline void background_worker_main();
-    inline void flush_directories() const;
-    inline void flush_regular_files() const;
-    inline void try_drop_directories();
-    inline void try_drop_regular_files();
+    /**
+     * Remove queued data objects in order, until stopped with nothing queued
+     */
+    inline void reclaimer_main();
+    /**
+     * Time dirty entries are flushed by, which comes earlier as they grow
+     */
+    [[nodiscard]] inline std::optional<std::chrono::system_clock::time_point> flush_deadline();
+    /**
+     * Record that an entry became dirty, and wake the background worker if nothing was dirty
+     */
+    inline void note_dirty(std::unique_lock<std::mutex>& dirty_lock);
+    /**
+     * Run a function on batches of items by flusher threads, and wait for every batch
+     */
+    template<typename item_type, typename function_type>
+    inline void flush_in_parallel(const std::vector<item_type>& items, function_type function);
+    /**
+     * Put an entry taken by a flush back into its dirty set, keeping the charge it was taken with
+     */
+    template<typename entry_type>
+    inline void keep_dirty(std::unordered_map<entry_type*, size_t>& dirty_entries, entry_type* entry, size_t bytes);
+    inline void flush_directories();
+    inline void flush_metadata();
+    inline void apply_entry_updates();
+    /**
+     * Bytes charged to dirty_throttle for an entry queued by update_entry
+     */
+    [[nodiscard]] static constexpr size_t pending_entry_bytes(std::string_view path);
+    inline void discard_entry_update(std::string_view path);
+    inline void drop_expired();
+    inline void request_eviction();
+    /**
+     * Evict closed and clean entries selected by caching policy
+     */
+    inline void drop_victims();
 };
 
 }
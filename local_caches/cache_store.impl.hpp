@@ -6,28 +6,59 @@
 #include "../logger/log.hpp"
 #include "../exceptions/type_not_supported.hpp"
 #include "utils/no_lock.hpp"
+#include "../kv_backends/io_priority.hpp"
+#include "../structures/utils/data_object_key.hpp"
 
 namespace nmfs {
 
 template<typename indexing, typename caching_policy>
 cache_store<indexing, caching_policy>::cache_store(super_object<indexing>& context)
     : context(context),
-      background_worker(std::bind(&cache_store::background_worker_main, this)) {
+      policy(context.options),
+      negative_entries(paths, configuration::negative_cache_capacity, policy.negative_valid_duration),
+      renames(*context.backend),
+      rename_queue(indexing::path_keyed ? configuration::rename_parallelism : 0),
+      flush_queue(configuration::flush_parallelism),
+      background_worker(std::bind(&cache_store::background_worker_main, this)),
+      reclaimer(std::bind(&cache_store::reclaimer_main, this)) {
 }
 
 template<typename indexing, typename caching_policy>
 cache_store<indexing, caching_policy>::~cache_store() {
-    stop_background_worker = true;
+    {
+        auto lock = std::unique_lock(background_worker_mutex);
+        stop_background_worker = true;
+    }
+    background_worker_wakeup.notify_one();
     background_worker.join();
+
+    // Entries flush themselves into members of this store when destroyed, so they are written and destroyed before the
+    // members are
+    try {
+        flush_all();
+    } catch (std::exception& e) {
+        log::error(log_locations::cache_store_operation) << __func__ << ": flush failed: " << e.what() << '\n';
+    }
+
+    // Data objects queued for removal are removed before the backend is closed
+    {
+        auto lock = std::unique_lock(reclamation_mutex);
+        stop_reclaimer = true;
+    }
+    reclaimer_wakeup.notify_one();
+    reclaimer.join();
+
+    directory_cache.clear();
+    cache.clear();
 }
 
 template<typename indexing, typename caching_policy>
 template<template<typename> typename lock_type>
 inline open_context<indexing, lock_type> cache_store<indexing, caching_policy>::open(std::string_view path) {
     log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
-    auto key_generator = std::function(indexing::existing_regular_file_key);
-    auto iterator = open(path, key_generator);
-    return open_context<indexing, lock_type>(iterator->first, iterator->second, true);
+    auto loader = std::function(indexing::load_regular_file_metadata);
+    // Open count is already increased by open
+    return open_context<indexing, lock_type>(path, open(path, loader));
 }
 
 template<typename indexing, typename caching_policy>
@@ -36,7 +67,7 @@ open_context<indexing, lock_type> cache_store<indexing, caching_policy>::create(
     log::information(log_locations::cache_store_operation) << std::showbase << __func__ << "(path = " << path << ", owner = " << owner << ", group = " << group << ", mode = " << std::oct << mode << ")\n";
 
     auto shared_cache_lock = std::shared_lock(cache_mutex);
-    bool does_exist = cache.contains(path);
+    bool does_exist = find_in(cache, path) != cache.end();
 
     shared_cache_lock.unlock();
 
@@ -48,11 +79,8 @@ open_context<indexing, lock_type> cache_store<indexing, caching_policy>::create(
             if (context.backend->exist(key)) {
                 throw nmfs::exceptions::file_already_exist(path);
             } else {
-                auto emplace_result = cache.emplace(
-                    std::string(path),
-                    std::move(temporary_metadata)
-                );
-                return emplace_result.first;
+                negative_entries.erase(path);
+                return emplace_in(cache, path, std::move(temporary_metadata));
             }
         };
 
@@ -62,7 +90,7 @@ open_context<indexing, lock_type> cache_store<indexing, caching_policy>::create(
 
             auto lock = std::scoped_lock(directory_cache_mutex, cache_mutex);
             auto iterator = do_create(std::move(key));
-            return open_context<indexing, lock_type>(iterator->first, iterator->second, true);
+            return open_context<indexing, lock_type>(path, iterator->second, true);
         } else if (S_ISREG(mode)) {
             auto key = indexing::new_regular_file_key(context, path, temporary_metadata);
             temporary_metadata.key = owner_slice(key);
@@ -70,7 +98,7 @@ open_context<indexing, lock_type> cache_store<indexing, caching_policy>::create(
             auto lock = std::unique_lock(cache_mutex);
             auto iterator = do_create(std::move(key));
             lock.unlock();
-            return open_context<indexing, lock_type>(iterator->first, iterator->second, true);
+            return open_context<indexing, lock_type>(path, iterator->second, true);
         } else {
             throw nmfs::exceptions::type_not_supported(mode);
         }
@@ -78,17 +106,19 @@ open_context<indexing, lock_type> cache_store<indexing, caching_policy>::create(
 }
 
 template<typename indexing, typename caching_policy>
-std::optional<typename std::map<std::string, typename cache_store<indexing, caching_policy>::metadata_type, std::less<>>::iterator> cache_store<indexing, caching_policy>::drop_if_policy_requires(std::string_view path, metadata<indexing>& metadata) {
+std::optional<typename cache_store<indexing, caching_policy>::metadata_map::iterator> cache_store<indexing, caching_policy>::drop_if_policy_requires(std::string_view path, metadata<indexing>& metadata) {
     log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
-    if (!caching_policy::keep_cache(context, metadata)) {
+    if (!policy.keep_cache(context, metadata)) {
         auto lock = std::unique_lock(cache_mutex);
-        auto iterator = cache.find(path);
+        auto iterator = find_in(cache, path);
         if (iterator != cache.end()) {
             assert(&(iterator->second) == &metadata); // assert if path and metadata is different
-            return cache.erase(iterator);
+            return erase_from(cache, iterator);
         } else {
             // TODO: Error handling - there is no cache with given path
         }
+    } else if (metadata.open_count == 0) {
+        schedule_expiration(path, metadata);
     }
     return std::nullopt;
 }
@@ -105,77 +135,145 @@ void cache_store<indexing, caching_policy>::remove(open_context<indexing, lock_t
 
     metadata.remove();
     open_context.unlock_and_release();
+    discard_entry_update(open_context.path);
 
     auto lock = std::unique_lock(cache_mutex);
-    cache.erase(cache.find(open_context.path));
+    // Found again under the exclusive lock, as it may have been dropped since it was opened
+    if (auto iterator = find_in(cache, open_context.path); iterator != cache.end()) {
+        erase_from(cache, iterator);
+    }
 }
 
 template<typename indexing, typename caching_policy>
 void cache_store<indexing, caching_policy>::move(std::string_view old_path, std::string_view new_path) {
     log::information(log_locations::cache_store_operation) << __func__ << "(old_path = " << old_path << ", new_path = " << new_path << ")\n";
+    if constexpr (!indexing::path_keyed) {
+        rename_cached(old_path, new_path);
+        return;
+    }
+
     auto& metadata = reinterpret_cast<metadata_type&>(open<no_lock>(old_path).unlock_and_release()); // To ensure metadata is in cache
-    auto cache_lock = std::unique_lock(cache_mutex);
-    auto metadata_iterator = cache.find(old_path);
-    cache_lock.unlock();
 
     if (metadata.open_count > 1) {
         log::warning(log_locations::cache_store_operation) << __func__ << ": Renaming opened file. open_count = " << metadata.open_count << '\n';
     }
 
     auto new_metadata_key = indexing::new_regular_file_key(context, new_path, metadata);
+    auto old_metadata_key = owner_slice(metadata.key);
+    // Old metadata is removed after new one is written, so the file is found under either key after a crash
+    metadata.valid = false;
     auto new_metadata = metadata_type(std::move(metadata), owner_slice(std::move(new_metadata_key)));
+    new_metadata.valid = true;
+    if (new_metadata.key != old_metadata_key) {
+        new_metadata.flush();
+        context.backend->remove(old_metadata_key);
+    }
+    discard_entry_update(old_path);
 
-    cache_lock.lock();
-    auto emplace_result = cache.emplace(
-        new_path,
-        std::move(new_metadata)
-    );
-    cache_lock.unlock();
-    auto& emplaced_new_metadata = emplace_result.first->second;
-
-    cache_lock.lock();
-    cache.erase(metadata_iterator);
+    auto cache_lock = std::unique_lock(cache_mutex);
+    negative_entries.erase(new_path);
+    // Looked up under this lock and erased before emplacing, as emplacing may rehash the cache
+    if (auto metadata_iterator = find_in(cache, old_path); metadata_iterator != cache.end()) {
+        erase_from(cache, metadata_iterator);
+    }
+    auto& emplaced_metadata = emplace_in(cache, new_path, std::move(new_metadata))->second;
+    schedule_expiration(new_path, emplaced_metadata);
 }
 
 template<typename indexing, typename caching_policy>
 mode_t cache_store<indexing, caching_policy>::get_type(std::string_view path) {
+    {
+        // Metadata is kept while the cache is locked, and its type never changes
+        auto cache_lock = std::shared_lock(cache_mutex);
+        auto iterator = find_in(cache, path);
+
+        if (iterator != cache.end()) {
+            if (auto metadata_lock = std::shared_lock(*iterator->second.mutex, std::try_to_lock)) {
+                return iterator->second.mode & S_IFMT;
+            }
+        }
+    }
     return indexing::get_type(context, path);
 }
 
+template<typename indexing, typename caching_policy>
+bool cache_store<indexing, caching_policy>::is_known_nonexistent(std::string_view path) const {
+    return negative_entries.contains(path);
+}
+
+template<typename indexing, typename caching_policy>
+uint64_t cache_store<indexing, caching_policy>::nonexistent_generation() const {
+    return negative_entries.generation();
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::remember_nonexistent(std::string_view path, uint64_t generation) {
+    log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
+    negative_entries.insert(path, generation);
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::forget_nonexistent(std::string_view path) {
+    negative_entries.erase(path);
+}
+
+template<typename indexing, typename caching_policy>
+std::chrono::system_clock::duration cache_store<indexing, caching_policy>::negative_valid_duration() const {
+    return policy.negative_valid_duration;
+}
+
 template<typename indexing, typename caching_policy>
 template<template<typename> typename lock_type>
 directory_open_context<indexing, lock_type> cache_store<indexing, caching_policy>::open_directory(std::string_view path) {
     log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
     auto directory_shared_lock = std::shared_lock(directory_cache_mutex);
-    auto iterator = directory_cache.find(path);
-
-    directory_shared_lock.unlock();
+    auto iterator = find_in(directory_cache, path);
+    bool expired = false;
 
+    // Iterators are invalidated by a concurrent emplace, so only the node and the directory are kept once unlocked
     if (iterator != directory_cache.end()) {
+        path_node* node = iterator->first;
         auto& directory = iterator->second;
 
-        if (caching_policy::is_valid(context, directory)) {
+        if (policy.is_valid(context, directory)) {
+            // Opened while the cache is locked, so it is not evicted before being locked
             directory.directory_metadata.open_count++;
-            return directory_open_context<indexing, lock_type>(path, directory, true);
-        } else {
-            // Drop directory cache and reopen
-            auto directory_unique_lock = std::unique_lock(directory_cache_mutex);
-            directory_cache.erase(iterator);
+            directory_shared_lock.unlock();
+
+            auto directory_context = directory_open_context<indexing, lock_type>(path, directory);
+            policy.accessed(context, node, directory);
+            return directory_context;
+        }
+        expired = true;
+    }
+    directory_shared_lock.unlock();
+
+    if (expired) {
+        // Drop directory cache and reopen, unless it was reloaded meanwhile
+        auto directory_unique_lock = std::unique_lock(directory_cache_mutex);
+        if (auto current = find_in(directory_cache, path); current != directory_cache.end() && !policy.is_valid(context, current->second)) {
+            erase_from(directory_cache, current);
         }
     }
 
     // If directory doesn't exist, an exception will be thrown from open
-    auto key_generator = std::function(indexing::existing_directory_key);
-    auto metadata_iterator = open(path, key_generator);
-    metadata<indexing>& directory_metadata = metadata_iterator->second;
+    auto loader = std::function(indexing::load_directory_metadata);
+    metadata<indexing>& directory_metadata = open(path, loader);
 
     auto directory_unique_lock = std::unique_lock(directory_cache_mutex);
-    auto emplace_result = directory_cache.emplace(
-        std::string(path),
-        directory_metadata
-    );
+    auto& directory = emplace_in(directory_cache, path, directory_metadata)->second;
     directory_unique_lock.unlock();
-    return directory_open_context<indexing, lock_type>(emplace_result.first->first, emplace_result.first->second);
+    // Open count is already increased by open
+    return directory_open_context<indexing, lock_type>(path, directory);
+}
+
+template<typename indexing, typename caching_policy>
+template<template<typename> typename lock_type>
+open_context<indexing, lock_type> cache_store<indexing, caching_policy>::open_directory_metadata(std::string_view path) {
+    log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
+    auto loader = std::function(indexing::load_directory_metadata);
+    // Open count is already increased by open
+    return open_context<indexing, lock_type>(path, open(path, loader));
 }
 
 template<typename indexing, typename caching_policy>
@@ -185,23 +283,21 @@ directory_open_context<indexing, lock_type> cache_store<indexing, caching_policy
     // If directory exists, an exception will be thrown from create
     metadata<indexing>& directory_metadata = create<no_lock>(path, owner, group, mode).unlock_and_release();
     auto lock = std::unique_lock(directory_cache_mutex);
-    auto emplace_result = directory_cache.emplace(
-        std::string(path),
-        directory_metadata
-    );
+    auto& directory = emplace_in(directory_cache, path, directory_metadata)->second;
     lock.unlock();
-    return directory_open_context<indexing, lock_type>(emplace_result.first->first, emplace_result.first->second, true);
+    // Open count is already increased by create
+    return directory_open_context<indexing, lock_type>(path, directory);
 }
 
 template<typename indexing, typename caching_policy>
-std::optional<typename std::map<std::string, directory<indexing>, std::less<>>::iterator> cache_store<indexing, caching_policy>::drop_if_policy_requires(std::string_view path, directory<indexing>& directory) {
+std::optional<typename cache_store<indexing, caching_policy>::directory_map::iterator> cache_store<indexing, caching_policy>::drop_if_policy_requires(std::string_view path, directory<indexing>& directory) {
     log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
-    if (!caching_policy::keep_cache(context, directory)) {
+    if (!policy.keep_cache(context, directory)) {
         auto lock = std::unique_lock(directory_cache_mutex);
-        auto iterator = directory_cache.find(path);
+        auto iterator = find_in(directory_cache, path);
         if (iterator != directory_cache.end()) {
             assert(&(iterator->second) == &directory); // assert if path and directory is different
-            return directory_cache.erase(iterator);
+            return erase_from(directory_cache, iterator);
         } else {
             // TODO: Error handling - there is no cache with given path
         }
@@ -226,88 +322,574 @@ void cache_store<indexing, caching_policy>::remove_directory(directory_open_cont
     directory_open_context.unlock_and_release_directory();
 
     auto lock = std::scoped_lock(directory_cache_mutex, cache_mutex);
-    directory_cache.erase(directory_cache.find(path));
-    cache.erase(cache.find(path));
+    if (auto directory_iterator = find_in(directory_cache, path); directory_iterator != directory_cache.end()) {
+        erase_from(directory_cache, directory_iterator);
+    }
+    if (auto metadata_iterator = find_in(cache, path); metadata_iterator != cache.end()) {
+        erase_from(cache, metadata_iterator);
+    }
 }
 
 template<typename indexing, typename caching_policy>
 void cache_store<indexing, caching_policy>::move_directory(std::string_view old_path, std::string_view new_path) {
     log::information(log_locations::cache_store_operation) << __func__ << "(old_path = " << old_path << ", new_path = " << new_path << ")\n";
+    if constexpr (!indexing::path_keyed) {
+        rename_cached(old_path, new_path);
+        return;
+    }
+
+    auto progress = rename_progress {
+        .path = old_path,
+    };
+
+    renames.begin(old_path, new_path);
+    move_subtree(old_path, new_path, progress);
+    log::information(log_locations::cache_store_operation) << __func__ << ": moved " << progress.moved_entries << " entries (old_path = " << old_path << ", new_path = " << new_path << ")\n";
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::finish_rename(std::string_view old_path) {
+    if constexpr (indexing::path_keyed) {
+        renames.end(old_path);
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::resume_renames() {
+    if constexpr (indexing::path_keyed) {
+        for (const auto& record: renames.pending()) {
+            log::warning(log_locations::cache_store_operation) << __func__ << ": resuming rename (old_path = " << record.old_path << ", new_path = " << record.new_path << ")\n";
+            auto progress = rename_progress {
+                .path = record.old_path,
+            };
+
+            try {
+                // A directory is removed from its old path only after everything under it is moved
+                if (context.backend->exist(indexing::existing_directory_key(context, record.old_path))) {
+                    move_subtree(record.old_path, record.new_path, progress);
+                }
+                restore_parent_entries(record.old_path, record.new_path);
+            } catch (nmfs::exceptions::file_does_not_exist& e) {
+                log::warning(log_locations::cache_store_operation) << __func__ << ": rename can't be resumed (old_path = " << record.old_path << "): " << e.what() << '\n';
+            }
+            renames.end(record.old_path);
+        }
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::move_subtree(std::string_view old_path, std::string_view new_path, rename_progress& progress) {
     auto& directory = open_directory<no_lock>(old_path).unlock_and_release_directory(); // To ensure directory is in cache
     auto& directory_metadata = dynamic_cast<metadata_type&>(directory.directory_metadata);
-    auto directory_iterator = directory_cache.find(old_path);
-    auto metadata_iterator = cache.find(old_path);
 
     if (directory_metadata.open_count > 1) {
         log::warning(log_locations::cache_store_operation) << __func__ << ": Renaming opened directory. open_count = " << directory_metadata.open_count << '\n';
     }
 
+    // Entries are moved before their directory, which lists every entry not moved yet if a crash interrupts them
+    work_queue::task_group group;
+    directory.for_each_entry([this, old_path, new_path, &progress, &group](const directory_entry_type& file) {
+        auto old_entry_path = std::string(old_path) + path_delimiter + file.file_name;
+        auto new_entry_path = std::string(new_path) + path_delimiter + file.file_name;
+
+        rename_queue.submit(group, [this, old_entry_path = std::move(old_entry_path), new_entry_path = std::move(new_entry_path), &progress]() {
+            log::information(log_locations::cache_store_operation) << "Moving child entry (old_path = " << old_entry_path << ", new_path = " << new_entry_path << ")\n";
+            try {
+                mode_t type = get_type(old_entry_path);
+
+                if (S_ISDIR(type)) {
+                    move_subtree(old_entry_path, new_entry_path, progress);
+                } else if (S_ISREG(type)) {
+                    move(old_entry_path, new_entry_path);
+                } else {
+                    throw nmfs::exceptions::type_not_supported(type);
+                }
+            } catch (nmfs::exceptions::file_does_not_exist&) {
+                // Moved before the rename was interrupted
+            }
+
+            if (size_t moved_entries = ++progress.moved_entries; moved_entries % configuration::rename_progress_interval == 0) {
+                log::information(log_locations::cache_store_operation) << "move_directory: moved " << moved_entries << " entries (path = " << progress.path << ")\n";
+            }
+        });
+    });
+    rename_queue.wait(group);
+
+    // Fragments are rewritten under the new key by directory, so they must not be moved as data objects
+    directory.load_fragments();
+    directory_metadata.size = 0;
+    // Old metadata is removed by directory after new objects are written
+    directory_metadata.valid = false;
+
     auto new_metadata_key = indexing::new_directory_key(context, new_path, directory_metadata);
     auto new_metadata = metadata_type(std::move(directory_metadata), owner_slice(std::move(new_metadata_key)));
-    auto cache_lock = std::unique_lock(cache_mutex);
-    auto metadata_emplace_result = cache.emplace(
-        new_path,
-        std::move(new_metadata)
-    );
-    cache_lock.unlock();
-    auto& emplaced_metadata = metadata_emplace_result.first->second;
+    new_metadata.valid = true;
+    // Any path under new_path may have been remembered as nonexistent
+    negative_entries.clear();
+    auto unique_cache_lock = std::unique_lock(cache_mutex);
+    auto& emplaced_metadata = emplace_in(cache, new_path, std::move(new_metadata))->second;
+    unique_cache_lock.unlock();
 
-    auto new_directory = nmfs::structures::directory<indexing>(std::move(directory), emplaced_metadata, old_path, new_path);
+    auto new_directory = nmfs::structures::directory<indexing>(std::move(directory), emplaced_metadata);
     auto lock = std::scoped_lock(directory_cache_mutex, cache_mutex);
-    directory_cache.emplace(
-        new_path,
-        std::move(new_directory)
-    );
+    emplace_in(directory_cache, new_path, std::move(new_directory));
+
+    // Looked up under this lock, as renames of other entries may rehash both caches meanwhile
+    if (auto directory_iterator = find_in(directory_cache, old_path); directory_iterator != directory_cache.end()) {
+        erase_from(directory_cache, directory_iterator);
+    }
+    if (auto metadata_iterator = find_in(cache, old_path); metadata_iterator != cache.end()) {
+        erase_from(cache, metadata_iterator);
+    }
+    schedule_expiration(new_path, emplaced_metadata);
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::restore_parent_entries(std::string_view old_path, std::string_view new_path) {
+    std::string_view old_parent_path = get_parent_directory(old_path);
+    std::string_view new_parent_path = get_parent_directory(new_path);
+    std::string_view old_file_name = get_filename(old_path);
+    std::string_view new_file_name = get_filename(new_path);
+    auto contains = [](const directory<indexing>& directory, std::string_view file_name) {
+        try {
+            static_cast<void>(directory.get_entry(file_name));
+            return true;
+        } catch (nmfs::exceptions::file_does_not_exist&) {
+            return false;
+        }
+    };
+
+    auto old_parent_open_context = open_directory<std::unique_lock>(old_parent_path);
+    auto& old_parent_directory = old_parent_open_context.directory;
+    // Either parent may have been written before the crash
+    auto restore = [&](directory<indexing>& new_parent_directory) {
+        bool listed_at_old_path = contains(old_parent_directory, old_file_name);
+        bool listed_at_new_path = contains(new_parent_directory, new_file_name);
+
+        if (listed_at_old_path && !listed_at_new_path) {
+            old_parent_directory.move_entry(old_path, new_path, new_parent_directory);
+        } else if (listed_at_old_path) {
+            old_parent_directory.remove_file(old_file_name);
+        } else if (!listed_at_new_path) {
+            auto metadata_open_context = open_directory_metadata<std::shared_lock>(new_path);
+            new_parent_directory.add_file(new_file_name, metadata_open_context.metadata);
+        }
+        new_parent_directory.flush();
+    };
 
-    directory_cache.erase(directory_iterator);
-    cache.erase(metadata_iterator);
+    if (old_parent_path == new_parent_path) {
+        restore(old_parent_directory);
+    } else {
+        auto new_parent_open_context = open_directory<std::unique_lock>(new_parent_path);
+        restore(new_parent_open_context.directory);
+        old_parent_directory.flush();
+    }
 }
 
 template<typename indexing, typename caching_policy>
-void cache_store<indexing, caching_policy>::flush_all() const {
+std::vector<std::optional<struct stat>> cache_store<indexing, caching_policy>::stat_entries(std::string_view path, const std::vector<typename directory<indexing>::listed_entry>& entries) {
+    log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
+    std::vector<std::string> entry_paths;
+    std::vector<size_t> missing_indices;
+    std::vector<owner_slice> missing_keys;
+
+    for (const auto& [entry, cursor]: entries) {
+        std::string entry_path = std::string(path);
+        if (entry_path.empty() || entry_path.back() != path_delimiter) {
+            entry_path += path_delimiter;
+        }
+        entry_paths.push_back(entry_path + entry.file_name);
+    }
+
+    {
+        auto cache_shared_lock = std::shared_lock(cache_mutex);
+
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (find_in(cache, entry_paths[i]) == cache.end() && !indexing::entry_attributes(entries[i].entry).has_value()) {
+                missing_indices.push_back(i);
+                missing_keys.push_back(indexing::existing_entry_key(context, entry_paths[i], entries[i].entry));
+            }
+        }
+    }
+
+    if (!missing_keys.empty()) {
+        auto priority_scope = kv_backends::io_priority_scope(kv_backends::io_priority::prefetch);
+        auto values = context.backend->get(missing_keys, sizeof(typename indexing::on_disk_metadata_type));
+        auto cache_unique_lock = std::unique_lock(cache_mutex);
+
+        for (size_t i = 0; i < values.size(); i++) {
+            std::string_view entry_path = entry_paths[missing_indices[i]];
+
+            if (!values[i].has_value() || values[i]->size() < sizeof(typename indexing::on_disk_metadata_type) || find_in(cache, entry_path) != cache.end()) {
+                continue;
+            }
+
+            auto on_disk_metadata = reinterpret_cast<on_disk::metadata*>(values[i]->data());
+            auto& metadata = emplace_in(cache, entry_path, metadata_type(context, std::move(missing_keys[i]), on_disk_metadata))->second;
+            // Nobody opens a prefetched entry, so it expires as if it was closed now
+            schedule_expiration(entry_path, metadata);
+        }
+    }
+
+    std::vector<std::optional<struct stat>> stats(entry_paths.size());
+    auto cache_shared_lock = std::shared_lock(cache_mutex);
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        // Attributes kept in a directory entry are stale while its update is queued
+        auto pending = pending_entry(entry_paths[i]);
+        stats[i] = indexing::entry_attributes(pending.has_value() ? *pending : entries[i].entry);
+    }
+
+    for (size_t i = 0; i < entry_paths.size(); i++) {
+        auto iterator = find_in(cache, entry_paths[i]);
+        if (iterator == cache.end()) {
+            continue;
+        }
+
+        metadata<indexing>& metadata = iterator->second;
+        // Waiting for a writer while holding cache_mutex could deadlock against rename
+        auto metadata_lock = std::shared_lock(*metadata.mutex, std::try_to_lock);
+        if (metadata_lock.owns_lock() && policy.is_valid(context, metadata)) {
+            stats[i] = metadata.to_stat();
+        } else {
+            stats[i].reset();
+        }
+    }
+
+    return stats;
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::update_entry(std::string_view path, directory_entry_type entry) {
+    log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
+    auto lock = std::unique_lock(pending_entries_mutex);
+    if (pending_entries.insert_or_assign(std::string(path), std::move(entry)).second) {
+        throttle.charge(1, pending_entry_bytes(path));
+    }
+}
+
+template<typename indexing, typename caching_policy>
+std::optional<typename cache_store<indexing, caching_policy>::directory_entry_type> cache_store<indexing, caching_policy>::pending_entry(std::string_view path) {
+    auto lock = std::unique_lock(pending_entries_mutex);
+    auto iterator = pending_entries.find(std::string(path));
+
+    if (iterator != pending_entries.end()) {
+        return iterator->second;
+    } else {
+        return std::nullopt;
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::reclaim(const slice& key, uint32_t index_from, uint32_t index_to) {
+    log::information(log_locations::cache_store_operation) << __func__ << "(index_from = " << index_from << ", index_to = " << index_to << ")\n";
+    {
+        auto lock = std::unique_lock(reclamation_mutex);
+        reclaiming_keys[key.to_string()]++;
+        number_of_reclamations++;
+        reclamations.push_back(reclamation {
+            .key = owner_slice(key),
+            .index_from = index_from,
+            .index_to = index_to,
+        });
+    }
+    reclaimer_wakeup.notify_one();
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::wait_for_reclamation(const slice& key) {
+    // Checked without the lock first, so reads and writes don't serialize on it while nothing is queued
+    if (number_of_reclamations.load() == 0) {
+        return;
+    }
+
+    auto key_string = key.to_string();
+    auto lock = std::unique_lock(reclamation_mutex);
+    reclaimed.wait(lock, [this, &key_string]() {
+        return !reclaiming_keys.contains(key_string);
+    });
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::flush_all() {
     log::information(log_locations::cache_store_operation) << __func__ << "()\n";
+    auto flush_lock = std::unique_lock(flush_mutex);
+    flush_metadata();
+    apply_entry_updates();
     flush_directories();
-    flush_regular_files();
+    context.backend->sync();
 }
 
 template<typename indexing, typename caching_policy>
-template<typename slice_type>
-typename std::map<std::string, typename cache_store<indexing, caching_policy>::metadata_type, std::less<>>::iterator cache_store<indexing, caching_policy>::open(std::string_view path, std::function<slice_type(super_object<indexing>& , std::string_view)> key_generator) {
+void cache_store<indexing, caching_policy>::sync(std::string_view path, const metadata<indexing>& metadata) {
+    log::information(log_locations::cache_store_operation) << __func__ << "(path = " << path << ")\n";
+    metadata.flush();
+    // Objects truncated away are removed before the sync, so they don't come back after a crash
+    wait_for_reclamation(metadata.key);
+
+    if constexpr (indexing::attributes_in_entries) {
+        if (S_ISREG(metadata.mode)) {
+            std::optional<directory_entry_type> entry;
+            {
+                auto lock = std::unique_lock(pending_entries_mutex);
+                if (auto node = pending_entries.extract(std::string(path))) {
+                    entry.emplace(std::move(node.mapped()));
+                    throttle.discharge(1, pending_entry_bytes(path));
+                }
+            }
+            if (!entry.has_value()) {
+                // Entry may have been taken by a flush pass, which is waited for until it is applied to the parent
+                auto flush_lock = std::unique_lock(flush_mutex);
+            }
+
+            // Attributes kept in a directory entry are durable once the parent directory is written
+            auto parent_open_context = open_directory<std::shared_lock>(get_parent_directory(path));
+            if (entry.has_value()) {
+                parent_open_context.directory.update_entry(std::move(*entry));
+            }
+            parent_open_context.directory.flush();
+        }
+    }
+
+    backend_sync.wait([this]() {
+        context.backend->sync();
+    });
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::sync(const directory<indexing>& directory) {
+    log::information(log_locations::cache_store_operation) << __func__ << "()\n";
+    directory.flush();
+
+    backend_sync.wait([this]() {
+        context.backend->sync();
+    });
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::mark_dirty(metadata<indexing>& metadata) {
+    size_t bytes = metadata.memory_usage();
+    auto lock = std::unique_lock(dirty_mutex);
+
+    if (dirty_metadata.emplace(&metadata, bytes).second) {
+        throttle.charge(1, bytes);
+        note_dirty(lock);
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::mark_dirty(directory<indexing>& directory, size_t bytes) {
+    auto lock = std::unique_lock(dirty_mutex);
+    auto [iterator, inserted] = dirty_directories.try_emplace(&directory, 0);
+
+    if (inserted) {
+        bytes += sizeof(structures::on_disk::directory_fragment);
+    }
+    iterator->second += bytes;
+    throttle.charge(inserted ? 1 : 0, bytes);
+    if (inserted) {
+        note_dirty(lock);
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::balance_dirty() {
+    if (throttle.over_soft_limit()) {
+        {
+            auto lock = std::unique_lock(background_worker_mutex);
+            flush_requested = true;
+        }
+        background_worker_wakeup.notify_one();
+    }
+    throttle.balance();
+}
+
+template<typename indexing, typename caching_policy>
+typename cache_store<indexing, caching_policy>::metadata_type& cache_store<indexing, caching_policy>::open(std::string_view path, std::function<metadata_type(super_object<indexing>&, std::string_view)> loader) {
     auto cache_shared_lock = std::shared_lock(cache_mutex);
-    auto iterator = cache.find(path);
+    auto iterator = find_in(cache, path);
+
+    // Iterators are invalidated by a concurrent emplace, so only the node and the metadata are kept once unlocked
+    if (iterator != cache.end()) {
+        path_node* node = iterator->first;
+        metadata_type& metadata = iterator->second;
+
+        // Opened while the cache is locked, so it is not evicted before being locked
+        metadata.open_count++;
+        cache_shared_lock.unlock();
 
+        {
+            auto metadata_lock = std::unique_lock(*metadata.mutex);
+            if (!policy.is_valid(context, metadata)) {
+                metadata.reload();
+            }
+        }
+        policy.accessed(context, node, metadata);
+        return metadata;
+    }
     cache_shared_lock.unlock();
 
-    if (iterator != cache.end()) {
-        metadata<indexing>& metadata = iterator->second;
-        auto metadata_lock = std::unique_lock(*metadata.mutex);
+    try {
+        auto loaded_metadata = loader(context, path);
 
-        if (!caching_policy::is_valid(context, metadata)) {
-            metadata.reload();
+        auto cache_unique_lock = std::unique_lock(cache_mutex);
+        auto& metadata = emplace_in(cache, path, std::move(loaded_metadata))->second;
+        metadata.open_count++;
+        return metadata;
+    } catch (kv_backends::exceptions::key_does_not_exist& e) {
+        throw nmfs::exceptions::file_does_not_exist(path);
+    }
+}
+
+template<typename indexing, typename caching_policy>
+template<typename map_type>
+typename map_type::iterator cache_store<indexing, caching_policy>::find_in(map_type& map, std::string_view path) {
+    path_node* node = paths.find(path);
+    return node != nullptr ? map.find(node) : map.end();
+}
+
+template<typename indexing, typename caching_policy>
+template<typename map_type, typename... argument_types>
+typename map_type::iterator cache_store<indexing, caching_policy>::emplace_in(map_type& map, std::string_view path, argument_types&&... arguments) {
+    path_node* node = paths.intern(path);
+    auto emplace_result = map.emplace(
+        std::piecewise_construct,
+        std::forward_as_tuple(node),
+        std::forward_as_tuple(std::forward<argument_types>(arguments)...)
+    );
+
+    if (emplace_result.second) {
+        track(emplace_result.first->second);
+        policy.inserted(context, node, emplace_result.first->second);
+        if (policy.over_budget()) {
+            request_eviction();
         }
-        return iterator;
     } else {
-        slice_type key = key_generator(context, path);
-        try {
-            owner_slice value = context.backend->get(key, sizeof(typename indexing::on_disk_metadata_type));
-            auto on_disk_metadata = reinterpret_cast<on_disk::metadata*>(value.data());
-
-            auto cache_unique_lock = std::unique_lock(cache_mutex);
-            auto emplace_result = cache.emplace(
-                std::string(path),
-                metadata_type(context, owner_slice(std::move(key)), on_disk_metadata)
-            );
-            return emplace_result.first;
-        } catch (kv_backends::exceptions::key_does_not_exist& e) {
-            throw nmfs::exceptions::file_does_not_exist(path);
+        paths.release(node);
+    }
+    return emplace_result.first;
+}
+
+template<typename indexing, typename caching_policy>
+template<typename map_type>
+typename map_type::iterator cache_store<indexing, caching_policy>::erase_from(map_type& map, typename map_type::iterator iterator) {
+    path_node* node = iterator->first;
+    untrack(iterator->second);
+    policy.erased(context, node, iterator->second);
+    auto next = map.erase(iterator);
+
+    paths.release(node);
+    return next;
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::track(metadata_type& metadata) {
+    if (metadata.dirty) {
+        mark_dirty(metadata);
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::track(directory<indexing>& directory) {
+    if (directory.is_dirty()) {
+        mark_dirty(directory);
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::untrack(metadata_type& metadata) {
+    auto lock = std::unique_lock(dirty_mutex);
+    if (auto node = dirty_metadata.extract(&metadata)) {
+        throttle.discharge(1, node.mapped());
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::untrack(directory<indexing>& directory) {
+    auto lock = std::unique_lock(dirty_mutex);
+    if (auto node = dirty_directories.extract(&directory)) {
+        throttle.discharge(1, node.mapped());
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::schedule_expiration(std::string_view path, const metadata<indexing>& metadata) {
+    path_node* node = paths.intern(path);
+    auto lock = std::unique_lock(expiration_mutex);
+
+    expirations.push(expiration {
+        .deadline = metadata.last_close + policy.valid_duration,
+        .node = node,
+    });
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::rename_cached(std::string_view old_path, std::string_view new_path) {
+    auto lock = std::scoped_lock(directory_cache_mutex, cache_mutex);
+
+    // Any path under new_path may have been remembered as nonexistent
+    negative_entries.clear();
+    // Entries of a replaced target are dropped by rename before, unless they were cached again meanwhile
+    drop_cached(directory_cache, new_path);
+    drop_cached(cache, new_path);
+    paths.move(old_path, new_path);
+}
+
+template<typename indexing, typename caching_policy>
+template<typename map_type>
+void cache_store<indexing, caching_policy>::drop_cached(map_type& map, std::string_view path) {
+    if (auto iterator = find_in(map, path); iterator != map.end()) {
+        log::warning(log_locations::cache_store_operation) << __func__ << ": " << path << " is still cached\n";
+        erase_from(map, iterator);
+    }
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::reclaimer_main() {
+    auto priority_scope = kv_backends::io_priority_scope(kv_backends::io_priority::reclamation);
+    auto lock = std::unique_lock(reclamation_mutex);
+
+    while (true) {
+        reclaimer_wakeup.wait(lock, [this]() {
+            return stop_reclaimer || !reclamations.empty();
+        });
+        if (reclamations.empty()) {
+            return;
         }
+        auto task = std::move(reclamations.front());
+        reclamations.pop_front();
+        lock.unlock();
+
+        auto data_key = structures::utils::data_object_key(task.key, task.index_from);
+        for (uint32_t i = task.index_from; i <= task.index_to; i++) {
+            data_key.update_index(i);
+            try {
+                context.backend->remove(data_key);
+            } catch (std::exception& e) {
+                // Left behind, as the file no longer refers to it
+                log::error(log_locations::cache_store_operation) << "reclaimer: remove failed: " << e.what() << '\n';
+            }
+        }
+
+        lock.lock();
+        auto iterator = reclaiming_keys.find(task.key.to_string());
+        if (--iterator->second == 0) {
+            reclaiming_keys.erase(iterator);
+        }
+        number_of_reclamations--;
+        reclaimed.notify_all();
     }
 }
 
+template<typename indexing, typename caching_policy>
+constexpr bool cache_store<indexing, caching_policy>::expiration::operator>(const expiration& other) const {
+    return deadline > other.deadline;
+}
+
 template<typename indexing, typename caching_policy>
 void cache_store<indexing, caching_policy>::background_worker_main() {
     const int fail_threshold = 5;
-    const auto task_interval = std::chrono::seconds(5);
+    auto priority_scope = kv_backends::io_priority_scope(kv_backends::io_priority::flush);
     int cache_lock_fail_count = 0;
     int directory_cache_lock_fail_count = 0;
     auto try_flush = [this, fail_threshold](int& fail_count, std::shared_mutex& mutex, std::function<void()> flush) {
@@ -326,60 +908,273 @@ void cache_store<indexing, caching_policy>::background_worker_main() {
     };
 
     while (!stop_background_worker) {
-        auto next_task = std::chrono::system_clock::now() + task_interval;
+        auto next_task = std::chrono::system_clock::now() + configuration::flush_interval;
+
+        try {
+            auto flush_lock = std::unique_lock(flush_mutex);
+            try_flush(cache_lock_fail_count, cache_mutex, [this]() { flush_metadata(); });
+            apply_entry_updates();
+            try_flush(directory_cache_lock_fail_count, directory_cache_mutex, [this]() { flush_directories(); });
+            // Metadata and directories written by this task are committed as one batch
+            context.backend->sync();
+        } catch (std::exception& e) {
+            // Failed entries are kept dirty, and retried by the next task
+            log::error(log_locations::cache_store_operation) << "background_worker: flush failed: " << e.what() << '\n';
+        }
+        drop_expired();
+        drop_victims();
 
-        try_flush(cache_lock_fail_count, cache_mutex, [this]() { flush_regular_files(); });
-        try_flush(directory_cache_lock_fail_count, directory_cache_mutex, [this]() { flush_directories(); });
-        try_drop_directories();
-        try_drop_regular_files();
+        // Woken up early when caching policy is over its budget, dirty entries are over their soft limits, or the oldest
+        // dirty entry expires
+        auto lock = std::unique_lock(background_worker_mutex);
+        while (!stop_background_worker && !eviction_requested && !flush_requested) {
+            auto deadline = next_task;
+            flush_rescheduled = false;
+            lock.unlock();
+            if (auto dirty_deadline = flush_deadline()) {
+                deadline = std::min(deadline, *dirty_deadline);
+            }
+            lock.lock();
+
+            if (std::chrono::system_clock::now() >= deadline) {
+                break;
+            }
+            background_worker_wakeup.wait_until(lock, deadline, [this]() {
+                return stop_background_worker || eviction_requested || flush_requested || flush_rescheduled;
+            });
+        }
+        eviction_requested = false;
+        flush_requested = false;
+    }
+}
 
-        std::this_thread::sleep_until(next_task);
+template<typename indexing, typename caching_policy>
+std::optional<std::chrono::system_clock::time_point> cache_store<indexing, caching_policy>::flush_deadline() {
+    auto dirty_lock = std::unique_lock(dirty_mutex);
+    if (!oldest_dirty.has_value()) {
+        return std::nullopt;
     }
+
+    auto expire_duration = std::chrono::duration_cast<std::chrono::system_clock::duration>(configuration::dirty_expire_duration * (1.0 - throttle.fill()));
+    return *oldest_dirty + expire_duration;
 }
 
 template<typename indexing, typename caching_policy>
-void cache_store<indexing, caching_policy>::flush_directories() const {
-    for (const auto& cache_entry: directory_cache) {
-        const std::string& path = cache_entry.first;
-        const auto& directory = cache_entry.second;
-        const auto& metadata = directory.directory_metadata;
+void cache_store<indexing, caching_policy>::note_dirty(std::unique_lock<std::mutex>& dirty_lock) {
+    if (oldest_dirty.has_value()) {
+        return;
+    }
+    oldest_dirty = std::chrono::system_clock::now();
+    dirty_lock.unlock();
 
-        if (S_ISDIR(metadata.mode) && metadata.dirty) {
-            directory.flush();
+    {
+        auto lock = std::unique_lock(background_worker_mutex);
+        flush_rescheduled = true;
+    }
+    background_worker_wakeup.notify_one();
+}
+
+template<typename indexing, typename caching_policy>
+template<typename item_type, typename function_type>
+void cache_store<indexing, caching_policy>::flush_in_parallel(const std::vector<item_type>& items, function_type function) {
+    work_queue::task_group group;
+
+    for (size_t begin = 0; begin < items.size(); begin += configuration::flush_batch_size) {
+        size_t end = std::min(items.size(), begin + configuration::flush_batch_size);
+        flush_queue.submit(group, [&items, &function, begin, end]() {
+            auto priority_scope = kv_backends::io_priority_scope(kv_backends::io_priority::flush);
+            std::exception_ptr exception;
+
+            // Rest of the batch is still flushed after a failure, whose first exception is rethrown
+            for (size_t i = begin; i < end; i++) {
+                try {
+                    function(items[i]);
+                } catch (...) {
+                    if (!exception) {
+                        exception = std::current_exception();
+                    }
+                }
+            }
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        });
+    }
+    flush_queue.wait(group);
+}
+
+template<typename indexing, typename caching_policy>
+template<typename entry_type>
+void cache_store<indexing, caching_policy>::keep_dirty(std::unordered_map<entry_type*, size_t>& dirty_entries, entry_type* entry, size_t bytes) {
+    auto dirty_lock = std::unique_lock(dirty_mutex);
+    if (auto [position, inserted] = dirty_entries.emplace(entry, bytes); !inserted) {
+        // Marked dirty again meanwhile, which charged it as another entry
+        position->second += bytes;
+        throttle.discharge(1, 0);
+    }
+    note_dirty(dirty_lock);
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::flush_directories() {
+    auto dirty_lock = std::unique_lock(dirty_mutex);
+    auto directories = std::vector<std::pair<directory<indexing>*, size_t>>(dirty_directories.begin(), dirty_directories.end());
+    dirty_directories.clear();
+    if (dirty_metadata.empty()) {
+        oldest_dirty.reset();
+    }
+    dirty_lock.unlock();
+
+    flush_in_parallel(directories, [this](const std::pair<directory<indexing>*, size_t>& item) {
+        auto [directory, bytes] = item;
+        if (auto lock = std::shared_lock(*directory->directory_metadata.mutex, std::try_to_lock)) {
+            try {
+                directory->flush();
+            } catch (...) {
+                // Kept dirty and charged, so it is written again by the next task
+                keep_dirty(dirty_directories, directory, bytes);
+                throw;
+            }
+            throttle.discharge(1, bytes);
+        } else {
+            // In use, retry on next task
+            keep_dirty(dirty_directories, directory, bytes);
         }
+    });
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::flush_metadata() {
+    auto dirty_lock = std::unique_lock(dirty_mutex);
+    auto metadata_list = std::vector<std::pair<metadata<indexing>*, size_t>>(dirty_metadata.begin(), dirty_metadata.end());
+    dirty_metadata.clear();
+    if (dirty_directories.empty()) {
+        oldest_dirty.reset();
     }
+    dirty_lock.unlock();
+
+    flush_in_parallel(metadata_list, [this](const std::pair<metadata<indexing>*, size_t>& item) {
+        auto [metadata, bytes] = item;
+        if (auto lock = std::shared_lock(*metadata->mutex, std::try_to_lock)) {
+            try {
+                metadata->flush();
+            } catch (...) {
+                // Kept dirty and charged, so it is written again by the next task
+                keep_dirty(dirty_metadata, metadata, bytes);
+                throw;
+            }
+            throttle.discharge(1, bytes);
+        } else {
+            // In use, retry on next task
+            keep_dirty(dirty_metadata, metadata, bytes);
+        }
+    });
 }
 
 template<typename indexing, typename caching_policy>
-void cache_store<indexing, caching_policy>::flush_regular_files() const {
-    for (const auto& cache_entry: cache) {
-        const std::string& path = cache_entry.first;
-        const metadata_type& metadata = cache_entry.second;
+void cache_store<indexing, caching_policy>::apply_entry_updates() {
+    auto pending_lock = std::unique_lock(pending_entries_mutex);
+    auto updates = std::vector<std::pair<std::string, directory_entry_type>>(std::make_move_iterator(pending_entries.begin()), std::make_move_iterator(pending_entries.end()));
+    pending_entries.clear();
+    pending_lock.unlock();
+
+    size_t bytes = 0;
+    for (const auto& [path, entry]: updates) {
+        bytes += pending_entry_bytes(path);
+    }
+    // Entries applied to their parents are charged again as dirty directories
+    throttle.discharge(updates.size(), bytes);
 
-        if (S_ISREG(metadata.mode) && metadata.dirty) {
-            metadata.flush();
+    // Entries of different fragments of a parent are updated concurrently
+    flush_in_parallel(updates, [this](const std::pair<std::string, directory_entry_type>& update) {
+        const auto& [path, entry] = update;
+        try {
+            auto open_context = open_directory<std::shared_lock>(get_parent_directory(path));
+            if (!open_context.directory.update_entry(entry)) {
+                log::debug(log_locations::cache_store_operation) << "apply_entry_updates: entry was removed (path = " << path << ")\n";
+            }
+        } catch (nmfs::exceptions::file_does_not_exist&) {
+            log::debug(log_locations::cache_store_operation) << "apply_entry_updates: parent directory was removed (path = " << path << ")\n";
         }
+    });
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::discard_entry_update(std::string_view path) {
+    auto lock = std::unique_lock(pending_entries_mutex);
+    if (pending_entries.erase(std::string(path)) > 0) {
+        throttle.discharge(1, pending_entry_bytes(path));
     }
 }
 
 template<typename indexing, typename caching_policy>
-void cache_store<indexing, caching_policy>::try_drop_directories() {
-    for (auto iterator = directory_cache.begin(); iterator != directory_cache.end();) {
-        if (auto result = drop_if_policy_requires(iterator->first, iterator->second)) {
-            iterator = result.value();
-        } else {
-            iterator++;
+constexpr size_t cache_store<indexing, caching_policy>::pending_entry_bytes(std::string_view path) {
+    return sizeof(directory_entry_type) + path.size();
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::drop_expired() {
+    const auto now = std::chrono::system_clock::now();
+    auto expiration_lock = std::unique_lock(expiration_mutex);
+
+    while (!expirations.empty() && expirations.top().deadline < now) {
+        path_node* node = expirations.top().node;
+        expirations.pop();
+        expiration_lock.unlock();
+
+        {
+            auto lock = std::scoped_lock(directory_cache_mutex, cache_mutex);
+            auto directory_iterator = directory_cache.find(node);
+            auto metadata_iterator = cache.find(node);
+
+            if (directory_iterator != directory_cache.end() && !policy.keep_cache(context, directory_iterator->second)) {
+                erase_from(directory_cache, directory_iterator);
+                directory_iterator = directory_cache.end();
+            }
+            // Metadata of a cached directory is referenced by the directory
+            if (directory_iterator == directory_cache.end() && metadata_iterator != cache.end() && !policy.keep_cache(context, metadata_iterator->second)) {
+                erase_from(cache, metadata_iterator);
+            }
         }
+        paths.release(node);
+
+        expiration_lock.lock();
     }
 }
 
 template<typename indexing, typename caching_policy>
-void cache_store<indexing, caching_policy>::try_drop_regular_files() {
-    for (auto iterator = cache.begin(); iterator != cache.end();) {
-        if (auto result = drop_if_policy_requires(iterator->first, iterator->second)) {
-            iterator = result.value();
-        } else {
-            iterator++;
+void cache_store<indexing, caching_policy>::request_eviction() {
+    {
+        auto lock = std::unique_lock(background_worker_mutex);
+        eviction_requested = true;
+    }
+    background_worker_wakeup.notify_one();
+}
+
+template<typename indexing, typename caching_policy>
+void cache_store<indexing, caching_policy>::drop_victims() {
+    policy.update_target();
+    auto lock = std::scoped_lock(directory_cache_mutex, cache_mutex);
+
+    for (path_node* node: policy.victims(context)) {
+        auto directory_iterator = directory_cache.find(node);
+        auto metadata_iterator = cache.find(node);
+
+        if (directory_iterator != directory_cache.end()) {
+            auto& directory = directory_iterator->second;
+
+            if (directory.directory_metadata.open_count == 0 && !directory.is_dirty()) {
+                erase_from(directory_cache, directory_iterator);
+                directory_iterator = directory_cache.end();
+            }
+        }
+        // Metadata of a cached directory is referenced by the directory
+        if (directory_iterator == directory_cache.end() && metadata_iterator != cache.end()) {
+            auto& metadata = metadata_iterator->second;
+
+            if (metadata.open_count == 0 && !metadata.dirty) {
+                erase_from(cache, metadata_iterator);
+            }
         }
     }
 }
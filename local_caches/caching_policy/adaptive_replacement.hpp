@@ -0,0 +1,123 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_ADAPTIVE_REPLACEMENT_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_ADAPTIVE_REPLACEMENT_HPP
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../../mount_options.hpp"
+#include "../../structures/super_object.hpp"
+#include "../../structures/metadata.hpp"
+#include "../../structures/directory.hpp"
+#include "../utils/hit_statistics.hpp"
+#include "../utils/path_trie.hpp"
+#include "hold_closed_cache_for.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+/**
+ * Adaptive replacement cache (ARC) holding at most capacity closed entries
+ *
+ * Entries seen once and entries seen repeatedly are kept in separate lists, and the split between them adapts to
+ * hits on recently evicted entries. An entry is seen again only when touched in a later scan epoch than before, so a
+ * scan only passes through the list of entries seen once and doesn't evict the working set. Cached contents are
+ * reloaded after valid_duration as with hold_closed_cache_for.
+ */
+template<typename indexing>
+class adaptive_replacement: public hold_closed_cache_for<indexing> {
+public:
+    inline explicit adaptive_replacement(const mount_options& options);
+
+    inline bool keep_cache(super_object<indexing>& context, metadata<indexing>& cache);
+    inline bool keep_cache(super_object<indexing>& context, directory<indexing>& cache);
+
+    inline void inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    [[nodiscard]] inline bool over_budget() const;
+    inline std::vector<path_node*> victims(super_object<indexing>& context);
+    [[nodiscard]] constexpr const hit_statistics& statistics() const;
+
+private:
+    enum class list_type {
+        recent,
+        frequent,
+    };
+
+    struct resident_entry {
+        path_node* node;
+        /**
+         * Hash of the path, which identifies the entry after eviction
+         */
+        size_t key;
+        metadata<indexing>* cached_metadata;
+        list_type list;
+        /**
+         * Scan epoch of the last touch
+         */
+        uint64_t epoch;
+        bool pinned;
+    };
+
+    struct ghost_entry {
+        size_t key;
+        list_type list;
+    };
+
+    using ghost_list = std::list<ghost_entry>;
+
+    struct resident_list {
+        // Most recently used first
+        std::list<resident_entry> entries;
+        /**
+         * Opened or dirty entries met while selecting victims, which are not scanned again until they can be evicted
+         */
+        std::list<resident_entry> pinned;
+
+        [[nodiscard]] inline size_t size() const;
+        [[nodiscard]] inline bool empty() const;
+    };
+
+    using resident_iterator = typename std::list<resident_entry>::iterator;
+
+    const size_t capacity;
+    /**
+     * Target size of recent list, adapted by hits on ghosts
+     */
+    size_t recent_target = 0;
+    resident_list recent;
+    resident_list frequent;
+    // Most recently evicted first
+    ghost_list recent_ghosts;
+    ghost_list frequent_ghosts;
+    std::unordered_map<const metadata<indexing>*, resident_iterator> residents;
+    std::unordered_map<size_t, typename ghost_list::iterator> ghosts;
+    hit_statistics hit_counts;
+    mutable std::mutex mutex;
+
+    inline resident_list& list_of(list_type type);
+    inline std::list<resident_entry>& entries_of(const resident_entry& entry);
+    inline ghost_list& ghost_list_of(list_type type);
+    inline void promote(resident_iterator iterator);
+    inline void erase_ghost(typename ghost_list::iterator iterator);
+    /**
+     * Move pinned entries which can be evicted now back to the entries of their list
+     */
+    inline void unpin(resident_list& list);
+    /**
+     * Evict an entry from recent or frequent list into its ghost list
+     * @return Evicted node, or nullptr if all entries are in use
+     */
+    inline path_node* replace();
+    inline path_node* evict_from(resident_list& list, ghost_list& ghosts_of_list);
+    [[nodiscard]] static inline uint64_t current_epoch();
+};
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_ADAPTIVE_REPLACEMENT_HPP
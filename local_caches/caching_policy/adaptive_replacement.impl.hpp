@@ -0,0 +1,252 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_ADAPTIVE_REPLACEMENT_IMPL_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_ADAPTIVE_REPLACEMENT_IMPL_HPP
+
+#include "adaptive_replacement.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include "../../structures/super_object.hpp"
+#include "../../structures/metadata.hpp"
+#include "../../structures/directory.hpp"
+#include "../../logger/log.hpp"
+#include "../../configuration.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+template<typename indexing>
+adaptive_replacement<indexing>::adaptive_replacement(const mount_options& options)
+    : hold_closed_cache_for<indexing>(options),
+      capacity(options.cache_capacity) {
+}
+
+template<typename indexing>
+bool adaptive_replacement<indexing>::keep_cache(super_object<indexing>& context, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    return cache.open_count > 0 || residents.contains(&cache);
+}
+
+template<typename indexing>
+bool adaptive_replacement<indexing>::keep_cache(super_object<indexing>& context, directory<indexing>& cache) {
+    return keep_cache(context, cache.directory_metadata);
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    size_t key = node->path_hash;
+    auto lock = std::unique_lock(mutex);
+    auto ghost_iterator = ghosts.find(key);
+    auto destination = list_type::recent;
+
+    hit_counts.record_miss();
+    if (ghost_iterator != ghosts.end()) {
+        // Evicted too early, so give more room to the list it was evicted from
+        if (ghost_iterator->second->list == list_type::recent) {
+            size_t increase = std::max<size_t>(frequent_ghosts.size() / recent_ghosts.size(), 1);
+            recent_target = std::min(capacity, recent_target + increase);
+        } else {
+            size_t decrease = std::max<size_t>(recent_ghosts.size() / frequent_ghosts.size(), 1);
+            recent_target = recent_target > decrease ? recent_target - decrease : 0;
+        }
+        erase_ghost(ghost_iterator->second);
+        destination = list_type::frequent;
+    } else if (recent.size() + recent_ghosts.size() >= capacity && !recent_ghosts.empty()) {
+        erase_ghost(std::prev(recent_ghosts.end()));
+    } else if (recent.size() + frequent.size() + recent_ghosts.size() + frequent_ghosts.size() >= 2 * capacity && !frequent_ghosts.empty()) {
+        erase_ghost(std::prev(frequent_ghosts.end()));
+    }
+
+    auto& list = list_of(destination).entries;
+    list.push_front(resident_entry {
+        .node = node,
+        .key = key,
+        .cached_metadata = &cache,
+        .list = destination,
+        .epoch = current_epoch(),
+        .pinned = false,
+    });
+    residents.insert_or_assign(&cache, list.begin());
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    // Metadata of the directory is already inserted
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    auto iterator = residents.find(&cache);
+
+    hit_counts.record_hit();
+    if (iterator != residents.end()) {
+        auto entry = iterator->second;
+        uint64_t epoch = current_epoch();
+
+        if (entry->epoch != epoch || entry->list == list_type::frequent) {
+            promote(entry);
+        } else {
+            // Touched again by the same scan, which is not counted as being seen twice
+            recent.entries.splice(recent.entries.begin(), entries_of(*entry), entry);
+            entry->pinned = false;
+        }
+        entry->epoch = epoch;
+    }
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    accessed(context, node, cache.directory_metadata);
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    auto iterator = residents.find(&cache);
+
+    // Entries evicted by victims() are already moved to ghost lists
+    if (iterator != residents.end()) {
+        entries_of(*iterator->second).erase(iterator->second);
+        residents.erase(iterator);
+    }
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    // Metadata of the directory is erased separately
+}
+
+template<typename indexing>
+bool adaptive_replacement<indexing>::over_budget() const {
+    auto lock = std::unique_lock(mutex);
+    return recent.size() + frequent.size() > capacity;
+}
+
+template<typename indexing>
+std::vector<path_node*> adaptive_replacement<indexing>::victims(super_object<indexing>& context) {
+    auto lock = std::unique_lock(mutex);
+    std::vector<path_node*> result;
+
+    unpin(recent);
+    unpin(frequent);
+    while (recent.size() + frequent.size() > capacity) {
+        path_node* node = replace();
+        if (node == nullptr) {
+            break;
+        }
+        result.push_back(node);
+    }
+
+    log::information(log_locations::cache_store_operation) << __func__ << "(): recent = " << recent.size() << ", frequent = " << frequent.size() << ", recent_target = " << recent_target << ", hit_ratio = " << hit_counts.hit_ratio() << ", victims = " << result.size() << '\n';
+    return result;
+}
+
+template<typename indexing>
+constexpr const hit_statistics& adaptive_replacement<indexing>::statistics() const {
+    return hit_counts;
+}
+
+template<typename indexing>
+size_t adaptive_replacement<indexing>::resident_list::size() const {
+    return entries.size() + pinned.size();
+}
+
+template<typename indexing>
+bool adaptive_replacement<indexing>::resident_list::empty() const {
+    return entries.empty() && pinned.empty();
+}
+
+template<typename indexing>
+typename adaptive_replacement<indexing>::resident_list& adaptive_replacement<indexing>::list_of(list_type type) {
+    return type == list_type::recent ? recent : frequent;
+}
+
+template<typename indexing>
+std::list<typename adaptive_replacement<indexing>::resident_entry>& adaptive_replacement<indexing>::entries_of(const resident_entry& entry) {
+    auto& list = list_of(entry.list);
+    return entry.pinned ? list.pinned : list.entries;
+}
+
+template<typename indexing>
+typename adaptive_replacement<indexing>::ghost_list& adaptive_replacement<indexing>::ghost_list_of(list_type type) {
+    return type == list_type::recent ? recent_ghosts : frequent_ghosts;
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::promote(resident_iterator iterator) {
+    frequent.entries.splice(frequent.entries.begin(), entries_of(*iterator), iterator);
+    iterator->list = list_type::frequent;
+    iterator->pinned = false;
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::erase_ghost(typename ghost_list::iterator iterator) {
+    ghosts.erase(iterator->key);
+    ghost_list_of(iterator->list).erase(iterator);
+}
+
+template<typename indexing>
+path_node* adaptive_replacement<indexing>::replace() {
+    bool from_recent = !recent.empty() && (recent.size() > recent_target || frequent.empty());
+    path_node* node = from_recent ? evict_from(recent, recent_ghosts) : evict_from(frequent, frequent_ghosts);
+
+    if (node == nullptr) {
+        node = from_recent ? evict_from(frequent, frequent_ghosts) : evict_from(recent, recent_ghosts);
+    }
+    return node;
+}
+
+template<typename indexing>
+void adaptive_replacement<indexing>::unpin(resident_list& list) {
+    for (auto iterator = list.pinned.begin(); iterator != list.pinned.end();) {
+        auto next = std::next(iterator);
+        if (iterator->cached_metadata->open_count == 0 && !iterator->cached_metadata->dirty) {
+            // Used until recently, so it returns as the most recently used entry
+            list.entries.splice(list.entries.begin(), list.pinned, iterator);
+            iterator->pinned = false;
+        }
+        iterator = next;
+    }
+}
+
+template<typename indexing>
+path_node* adaptive_replacement<indexing>::evict_from(resident_list& list, ghost_list& ghosts_of_list) {
+    // Opened or dirty entries can't be evicted by cache_store, so they are set aside instead of being scanned again
+    while (!list.entries.empty() && (list.entries.back().cached_metadata->open_count > 0 || list.entries.back().cached_metadata->dirty)) {
+        auto iterator = std::prev(list.entries.end());
+        list.pinned.splice(list.pinned.begin(), list.entries, iterator);
+        iterator->pinned = true;
+    }
+
+    if (list.entries.empty()) {
+        return nullptr;
+    } else {
+        resident_entry entry = list.entries.back();
+        auto ghost_iterator = ghosts.find(entry.key);
+
+        list.entries.pop_back();
+        residents.erase(entry.cached_metadata);
+
+        if (ghost_iterator != ghosts.end()) {
+            erase_ghost(ghost_iterator->second);
+        }
+        ghosts_of_list.push_front(ghost_entry {
+            .key = entry.key,
+            .list = entry.list,
+        });
+        ghosts.emplace(entry.key, ghosts_of_list.begin());
+        if (ghosts_of_list.size() > capacity) {
+            erase_ghost(std::prev(ghosts_of_list.end()));
+        }
+        return entry.node;
+    }
+}
+
+template<typename indexing>
+uint64_t adaptive_replacement<indexing>::current_epoch() {
+    return std::chrono::steady_clock::now().time_since_epoch() / configuration::cache_scan_epoch_duration;
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_ADAPTIVE_REPLACEMENT_IMPL_HPP
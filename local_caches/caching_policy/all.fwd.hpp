@@ -3,10 +3,16 @@
 
 namespace nmfs::caching_policies {
 
+template<typename indexing>
+class adaptive_replacement;
 template<typename indexing>
 class evict_on_last_close;
-template<typename indexing, int seconds>
+template<typename indexing>
+class evict_over_memory_budget;
+template<typename indexing>
 class hold_closed_cache_for;
+template<typename indexing>
+class window_tiny_lfu;
 
 }
 
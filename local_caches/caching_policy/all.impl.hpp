@@ -1,7 +1,11 @@
 #ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_ALL_IMPL_HPP
 #define NMFS_LOCAL_CACHES_CACHING_POLICY_ALL_IMPL_HPP
 
+#include "policy_base.impl.hpp"
+#include "adaptive_replacement.impl.hpp"
 #include "evict_on_last_close.impl.hpp"
+#include "evict_over_memory_budget.impl.hpp"
 #include "hold_closed_cache_for.impl.hpp"
+#include "window_tiny_lfu.impl.hpp"
 
 #endif //NMFS_LOCAL_CACHES_CACHING_POLICY_ALL_IMPL_HPP
@@ -1,20 +1,31 @@
 #ifndef NMFS_LOCAL_CACHES_EVICT_POLICIES_EVICT_ON_LAST_CLOSE_HPP
 #define NMFS_LOCAL_CACHES_EVICT_POLICIES_EVICT_ON_LAST_CLOSE_HPP
 
+#include <chrono>
+#include "../../mount_options.hpp"
 #include "../../structures/super_object.hpp"
 #include "../../structures/metadata.hpp"
 #include "../../structures/directory.hpp"
+#include "policy_base.hpp"
 
 namespace nmfs::caching_policies {
 using namespace nmfs::structures;
 
 template<typename indexing>
-class evict_on_last_close {
+class evict_on_last_close: public policy_base<indexing> {
 public:
-    static bool is_valid(super_object<indexing>& context, metadata<indexing>& cache);
-    static bool keep_cache(super_object<indexing>& context, metadata<indexing>& cache);
-    static bool is_valid(super_object<indexing>& context, directory<indexing>& cache);
-    static bool keep_cache(super_object<indexing>& context, directory<indexing>& cache);
+    const std::chrono::system_clock::duration valid_duration = std::chrono::seconds(0);
+    /**
+     * Nothing is held after close, so nonexistent paths are not cached either
+     */
+    const std::chrono::system_clock::duration negative_valid_duration = valid_duration;
+
+    inline explicit evict_on_last_close(const mount_options& options);
+
+    inline bool is_valid(super_object<indexing>& context, metadata<indexing>& cache) const;
+    inline bool keep_cache(super_object<indexing>& context, metadata<indexing>& cache);
+    inline bool is_valid(super_object<indexing>& context, directory<indexing>& cache) const;
+    inline bool keep_cache(super_object<indexing>& context, directory<indexing>& cache);
 };
 
 }
@@ -11,7 +11,11 @@ namespace nmfs::caching_policies {
 using namespace nmfs::structures;
 
 template<typename indexing>
-bool evict_on_last_close<indexing>::is_valid(super_object<indexing>& context, metadata<indexing>& cache) {
+evict_on_last_close<indexing>::evict_on_last_close(const mount_options& options) {
+}
+
+template<typename indexing>
+bool evict_on_last_close<indexing>::is_valid(super_object<indexing>& context, metadata<indexing>& cache) const {
     return true;
 }
 
@@ -21,7 +25,7 @@ bool evict_on_last_close<indexing>::keep_cache(super_object<indexing>& context,
 }
 
 template<typename indexing>
-bool evict_on_last_close<indexing>::is_valid(super_object<indexing>& context, directory<indexing>& cache) {
+bool evict_on_last_close<indexing>::is_valid(super_object<indexing>& context, directory<indexing>& cache) const {
     return true;
 }
 
@@ -0,0 +1,85 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_EVICT_OVER_MEMORY_BUDGET_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_EVICT_OVER_MEMORY_BUDGET_HPP
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../../mount_options.hpp"
+#include "../../structures/super_object.hpp"
+#include "../../structures/metadata.hpp"
+#include "../../structures/directory.hpp"
+#include "../utils/memory_pressure.hpp"
+#include "../utils/path_trie.hpp"
+#include "hold_closed_cache_for.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+/**
+ * Hold closed cache for valid duration, while keeping memory usage of caches under budget
+ *
+ * Entries are evicted in CLOCK order when memory usage exceeds the budget. The budget is shrunk while the cgroup of
+ * this process is under memory pressure.
+ */
+template<typename indexing>
+class evict_over_memory_budget: public hold_closed_cache_for<indexing> {
+public:
+    /**
+     * Budget is halved while some tasks are stalled on memory for at least this percentage of time
+     */
+    static constexpr double some_pressure_threshold = 10;
+    /**
+     * Budget is quartered while all tasks are stalled on memory for at least this percentage of time
+     */
+    static constexpr double full_pressure_threshold = 1;
+
+    inline explicit evict_over_memory_budget(const mount_options& options);
+
+    inline void inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    [[nodiscard]] inline bool over_budget() const;
+    /**
+     * Read memory pressure, which may block on procfs, and measure directories changed since they were last measured,
+     * so caches are not locked meanwhile
+     */
+    inline void update_target();
+    inline std::vector<path_node*> victims(super_object<indexing>& context);
+    [[nodiscard]] inline size_t memory_usage() const;
+
+private:
+    struct clock_slot {
+        path_node* node = nullptr;
+        metadata<indexing>* cached_metadata = nullptr;
+        directory<indexing>* cached_directory = nullptr;
+        size_t metadata_bytes = 0;
+        size_t directory_bytes = 0;
+        bool referenced = false;
+    };
+
+    const size_t budget;
+    size_t target;
+    size_t usage = 0;
+    std::vector<clock_slot> slots;
+    std::vector<size_t> free_slots;
+    std::unordered_map<path_node*, size_t> slot_indices;
+    size_t hand = 0;
+    memory_pressure pressure;
+    mutable std::mutex mutex;
+
+    inline clock_slot& get_slot(path_node* node);
+    inline void charge(clock_slot& slot, size_t& charged_bytes, size_t new_bytes);
+    inline void release_slot_if_empty(path_node* node);
+    /**
+     * Bytes released by evicting the slot, counting only entries cache_store can evict as they are closed and clean
+     */
+    [[nodiscard]] inline size_t evictable_bytes(const clock_slot& slot) const;
+};
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_EVICT_OVER_MEMORY_BUDGET_HPP
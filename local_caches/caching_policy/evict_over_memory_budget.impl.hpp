@@ -0,0 +1,205 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_EVICT_OVER_MEMORY_BUDGET_IMPL_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_EVICT_OVER_MEMORY_BUDGET_IMPL_HPP
+
+#include "evict_over_memory_budget.hpp"
+
+#include "../../structures/super_object.hpp"
+#include "../../structures/metadata.hpp"
+#include "../../structures/directory.hpp"
+#include "../../logger/log.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+template<typename indexing>
+evict_over_memory_budget<indexing>::evict_over_memory_budget(const mount_options& options)
+    : hold_closed_cache_for<indexing>(options),
+      budget(options.cache_memory_budget),
+      target(options.cache_memory_budget) {
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    auto& slot = get_slot(node);
+    slot.cached_metadata = &cache;
+    charge(slot, slot.metadata_bytes, cache.memory_usage());
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    auto& slot = get_slot(node);
+    slot.cached_directory = &cache;
+    static_cast<void>(cache.take_resized());
+    charge(slot, slot.directory_bytes, cache.memory_usage());
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    get_slot(node).referenced = true;
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    get_slot(node).referenced = true;
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    if (slot_indices.contains(node)) {
+        auto& slot = get_slot(node);
+        usage -= slot.metadata_bytes;
+        slot.metadata_bytes = 0;
+        slot.cached_metadata = nullptr;
+        release_slot_if_empty(node);
+    }
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    if (slot_indices.contains(node)) {
+        auto& slot = get_slot(node);
+        usage -= slot.directory_bytes;
+        slot.directory_bytes = 0;
+        slot.cached_directory = nullptr;
+        release_slot_if_empty(node);
+    }
+}
+
+template<typename indexing>
+bool evict_over_memory_budget<indexing>::over_budget() const {
+    auto lock = std::unique_lock(mutex);
+    return usage > target;
+}
+
+template<typename indexing>
+std::vector<path_node*> evict_over_memory_budget<indexing>::victims(super_object<indexing>& context) {
+    auto lock = std::unique_lock(mutex);
+    std::vector<path_node*> result;
+
+    if (usage <= target || slots.empty()) {
+        return result;
+    }
+
+    size_t remaining_usage = usage;
+    // First pass clears referenced bits, so second pass always finds victims unless every slot is empty
+    for (size_t step = 0; step < 2 * slots.size() && remaining_usage > target; step++) {
+        auto& slot = slots[hand];
+
+        if (slot.node != nullptr) {
+            if (slot.referenced) {
+                slot.referenced = false;
+            } else if (size_t bytes = evictable_bytes(slot); bytes > 0) {
+                result.push_back(slot.node);
+                remaining_usage -= bytes;
+            }
+        }
+        hand = (hand + 1) % slots.size();
+    }
+
+    log::information(log_locations::cache_store_operation) << __func__ << "(): usage = " << usage << ", target = " << target << ", victims = " << result.size() << '\n';
+    return result;
+}
+
+template<typename indexing>
+size_t evict_over_memory_budget<indexing>::memory_usage() const {
+    auto lock = std::unique_lock(mutex);
+    return usage;
+}
+
+template<typename indexing>
+typename evict_over_memory_budget<indexing>::clock_slot& evict_over_memory_budget<indexing>::get_slot(path_node* node) {
+    auto iterator = slot_indices.find(node);
+
+    if (iterator != slot_indices.end()) {
+        return slots[iterator->second];
+    } else {
+        size_t index;
+
+        if (free_slots.empty()) {
+            index = slots.size();
+            slots.emplace_back();
+        } else {
+            index = free_slots.back();
+            free_slots.pop_back();
+        }
+        slot_indices.emplace(node, index);
+        slots[index] = clock_slot {
+            .node = node,
+            .referenced = true,
+        };
+        return slots[index];
+    }
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::charge(clock_slot& slot, size_t& charged_bytes, size_t new_bytes) {
+    usage = usage - charged_bytes + new_bytes;
+    charged_bytes = new_bytes;
+    slot.referenced = true;
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::release_slot_if_empty(path_node* node) {
+    auto iterator = slot_indices.find(node);
+    auto& slot = slots[iterator->second];
+
+    if (slot.metadata_bytes == 0 && slot.directory_bytes == 0) {
+        slot = clock_slot {};
+        free_slots.push_back(iterator->second);
+        slot_indices.erase(iterator);
+    }
+}
+
+template<typename indexing>
+void evict_over_memory_budget<indexing>::update_target() {
+    auto averages = pressure.read();
+    size_t new_target = budget;
+
+    if (averages.has_value() && averages->full_average_10 >= full_pressure_threshold) {
+        new_target = budget / 4;
+    } else if (averages.has_value() && averages->some_average_10 >= some_pressure_threshold) {
+        new_target = budget / 2;
+    }
+
+    auto lock = std::unique_lock(mutex);
+    target = new_target;
+
+    // Directories grow and shrink while cached, so those changed since they were last measured are measured again.
+    // They are not erased meanwhile, as erased() waits for the mutex.
+    for (auto& slot: slots) {
+        if (slot.cached_directory != nullptr && slot.cached_directory->take_resized()) {
+            size_t bytes = slot.cached_directory->memory_usage();
+            usage = usage - slot.directory_bytes + bytes;
+            slot.directory_bytes = bytes;
+        }
+    }
+}
+
+template<typename indexing>
+size_t evict_over_memory_budget<indexing>::evictable_bytes(const clock_slot& slot) const {
+    size_t bytes = 0;
+    bool directory_evicted = true;
+
+    // Same conditions as cache_store::drop_victims, whose locks are held while victims are selected
+    if (slot.cached_directory != nullptr) {
+        directory_evicted = slot.cached_directory->directory_metadata.open_count == 0 && !slot.cached_directory->is_dirty();
+        if (directory_evicted) {
+            bytes += slot.directory_bytes;
+        }
+    }
+    // Metadata of a cached directory is referenced by the directory
+    if (directory_evicted && slot.cached_metadata != nullptr && slot.cached_metadata->open_count == 0 && !slot.cached_metadata->dirty) {
+        bytes += slot.metadata_bytes;
+    }
+    return bytes;
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_EVICT_OVER_MEMORY_BUDGET_IMPL_HPP
@@ -2,22 +2,30 @@
 #define NMFS_LOCAL_CACHES_CACHING_POLICY_HOLD_CLOSED_CACHE_FOR_HPP
 
 #include <chrono>
+#include "../../mount_options.hpp"
 #include "../../structures/super_object.hpp"
 #include "../../structures/metadata.hpp"
 #include "../../structures/directory.hpp"
+#include "policy_base.hpp"
 
 namespace nmfs::caching_policies {
 using namespace nmfs::structures;
 
-template<typename indexing, int seconds>
-class hold_closed_cache_for {
+template<typename indexing>
+class hold_closed_cache_for: public policy_base<indexing> {
 public:
-    static constexpr auto valid_duration = std::chrono::seconds(seconds);
+    const std::chrono::system_clock::duration valid_duration;
+    /**
+     * Paths known not to exist are cached for the same duration
+     */
+    const std::chrono::system_clock::duration negative_valid_duration;
 
-    static bool is_valid(super_object<indexing>& context, metadata<indexing>& cache);
-    static bool keep_cache(super_object<indexing>& context, metadata<indexing>& cache);
-    static bool is_valid(super_object<indexing>& context, directory<indexing>& cache);
-    static bool keep_cache(super_object<indexing>& context, directory<indexing>& cache);
+    inline explicit hold_closed_cache_for(const mount_options& options);
+
+    inline bool is_valid(super_object<indexing>& context, metadata<indexing>& cache) const;
+    inline bool keep_cache(super_object<indexing>& context, metadata<indexing>& cache);
+    inline bool is_valid(super_object<indexing>& context, directory<indexing>& cache) const;
+    inline bool keep_cache(super_object<indexing>& context, directory<indexing>& cache);
 };
 
 }
@@ -10,23 +10,29 @@
 namespace nmfs::caching_policies {
 using namespace nmfs::structures;
 
-template<typename indexing, int seconds>
-bool hold_closed_cache_for<indexing, seconds>::is_valid(super_object<indexing>& context, metadata<indexing>& cache) {
+template<typename indexing>
+hold_closed_cache_for<indexing>::hold_closed_cache_for(const mount_options& options)
+    : valid_duration(options.cache_valid_duration),
+      negative_valid_duration(options.cache_valid_duration) {
+}
+
+template<typename indexing>
+bool hold_closed_cache_for<indexing>::is_valid(super_object<indexing>& context, metadata<indexing>& cache) const {
     return cache.open_count > 0 || cache.last_close + valid_duration >= std::chrono::system_clock::now();
 }
 
-template<typename indexing, int seconds>
-bool hold_closed_cache_for<indexing, seconds>::keep_cache(super_object<indexing>& context, metadata<indexing>& cache) {
+template<typename indexing>
+bool hold_closed_cache_for<indexing>::keep_cache(super_object<indexing>& context, metadata<indexing>& cache) {
     return cache.open_count > 0 || cache.last_close + valid_duration >= std::chrono::system_clock::now();
 }
 
-template<typename indexing, int seconds>
-bool hold_closed_cache_for<indexing, seconds>::is_valid(super_object<indexing>& context, directory<indexing>& cache) {
+template<typename indexing>
+bool hold_closed_cache_for<indexing>::is_valid(super_object<indexing>& context, directory<indexing>& cache) const {
     return cache.directory_metadata.open_count > 0 || cache.directory_metadata.last_close + valid_duration >= std::chrono::system_clock::now();
 }
 
-template<typename indexing, int seconds>
-bool hold_closed_cache_for<indexing, seconds>::keep_cache(super_object<indexing>& context, directory<indexing>& cache) {
+template<typename indexing>
+bool hold_closed_cache_for<indexing>::keep_cache(super_object<indexing>& context, directory<indexing>& cache) {
     return cache.directory_metadata.open_count > 0 || cache.directory_metadata.last_close + valid_duration >= std::chrono::system_clock::now();
 }
 
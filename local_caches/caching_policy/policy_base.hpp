@@ -0,0 +1,46 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_POLICY_BASE_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_POLICY_BASE_HPP
+
+#include <vector>
+#include "../../structures/super_object.hpp"
+#include "../../structures/metadata.hpp"
+#include "../../structures/directory.hpp"
+#include "../utils/path_trie.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+/**
+ * Default bookkeeping hooks of caching policies
+ *
+ * cache_store owns an instance of its caching policy and calls these hooks on it.
+ * Stateless policies can inherit them as they are.
+ */
+template<typename indexing>
+class policy_base {
+public:
+    inline void inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    /**
+     * @return true if cache_store should evict entries returned by victims() without waiting for next task
+     */
+    [[nodiscard]] inline bool over_budget() const;
+    /**
+     * Adjust the budget to the state of the system, which is called before victims() without locking caches
+     */
+    inline void update_target();
+    /**
+     * Select entries to be evicted
+     *
+     * Only closed and clean entries among them are evicted by cache_store. Both caches are locked while this is called.
+     */
+    inline std::vector<path_node*> victims(super_object<indexing>& context);
+};
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_POLICY_BASE_HPP
@@ -0,0 +1,49 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_POLICY_BASE_IMPL_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_POLICY_BASE_IMPL_HPP
+
+#include "policy_base.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+template<typename indexing>
+void policy_base<indexing>::inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+}
+
+template<typename indexing>
+void policy_base<indexing>::inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+}
+
+template<typename indexing>
+void policy_base<indexing>::accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+}
+
+template<typename indexing>
+void policy_base<indexing>::accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+}
+
+template<typename indexing>
+void policy_base<indexing>::erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+}
+
+template<typename indexing>
+void policy_base<indexing>::erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+}
+
+template<typename indexing>
+bool policy_base<indexing>::over_budget() const {
+    return false;
+}
+
+template<typename indexing>
+void policy_base<indexing>::update_target() {
+}
+
+template<typename indexing>
+std::vector<path_node*> policy_base<indexing>::victims(super_object<indexing>& context) {
+    return {};
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_POLICY_BASE_IMPL_HPP
@@ -0,0 +1,120 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_WINDOW_TINY_LFU_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_WINDOW_TINY_LFU_HPP
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../../mount_options.hpp"
+#include "../../structures/super_object.hpp"
+#include "../../structures/metadata.hpp"
+#include "../../structures/directory.hpp"
+#include "../utils/frequency_sketch.hpp"
+#include "../utils/hit_statistics.hpp"
+#include "../utils/path_trie.hpp"
+#include "hold_closed_cache_for.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+/**
+ * W-TinyLFU cache holding at most capacity closed entries
+ *
+ * New entries enter a small LRU window. An entry leaving the window is admitted to the main segmented LRU only if it
+ * was accessed more frequently than the entry it would replace, so entries touched once by a scan rarely reach the
+ * main cache. Touches within one scan epoch count as one access, so a scan touching an entry repeatedly doesn't promote
+ * it either. Cached contents are reloaded after valid_duration as with hold_closed_cache_for.
+ */
+template<typename indexing>
+class window_tiny_lfu: public hold_closed_cache_for<indexing> {
+public:
+    /**
+     * Percentage of capacity used by window
+     */
+    static constexpr size_t window_percentage = 1;
+    /**
+     * Percentage of main cache used by protected segment
+     */
+    static constexpr size_t protected_percentage = 80;
+
+    inline explicit window_tiny_lfu(const mount_options& options);
+
+    inline bool keep_cache(super_object<indexing>& context, metadata<indexing>& cache);
+    inline bool keep_cache(super_object<indexing>& context, directory<indexing>& cache);
+
+    inline void inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache);
+    inline void erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache);
+    [[nodiscard]] inline bool over_budget() const;
+    inline std::vector<path_node*> victims(super_object<indexing>& context);
+    [[nodiscard]] constexpr const hit_statistics& statistics() const;
+
+private:
+    enum class segment_type {
+        window,
+        probation,
+        protected_segment,
+    };
+
+    struct resident_entry {
+        path_node* node;
+        /**
+         * Hash of the path, used as the key of frequency sketch
+         */
+        size_t key;
+        metadata<indexing>* cached_metadata;
+        segment_type segment;
+        /**
+         * Scan epoch of the last access counted by the sketch
+         */
+        uint64_t epoch;
+        bool pinned;
+    };
+
+    using resident_list = std::list<resident_entry>;
+
+    struct segment {
+        // Most recently used first
+        resident_list entries;
+        /**
+         * Opened or dirty entries met while selecting victims, which are not scanned again until they can be evicted
+         */
+        resident_list pinned;
+
+        [[nodiscard]] inline size_t size() const;
+    };
+
+    const size_t capacity;
+    const size_t window_capacity;
+    const size_t protected_capacity;
+    segment window;
+    segment probation;
+    segment protected_segment;
+    std::unordered_map<const metadata<indexing>*, typename resident_list::iterator> residents;
+    frequency_sketch sketch;
+    hit_statistics hit_counts;
+    mutable std::mutex mutex;
+
+    inline segment& segment_of(segment_type type);
+    inline resident_list& list_of(const resident_entry& entry);
+    inline void move_to(typename resident_list::iterator iterator, segment_type destination);
+    [[nodiscard]] inline size_t main_size() const;
+    /**
+     * Move pinned entries which can be evicted now back to the entries of their segment
+     */
+    inline void unpin(segment& target);
+    /**
+     * @return Least recently used entry of the segment which can be evicted, or end of its entries if there is none
+     */
+    inline typename resident_list::iterator find_evictable(segment& target);
+    inline path_node* evict(typename resident_list::iterator iterator);
+    [[nodiscard]] static inline uint64_t current_epoch();
+};
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_WINDOW_TINY_LFU_HPP
@@ -0,0 +1,248 @@
+#ifndef NMFS_LOCAL_CACHES_CACHING_POLICY_WINDOW_TINY_LFU_IMPL_HPP
+#define NMFS_LOCAL_CACHES_CACHING_POLICY_WINDOW_TINY_LFU_IMPL_HPP
+
+#include "window_tiny_lfu.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include "../../structures/super_object.hpp"
+#include "../../structures/metadata.hpp"
+#include "../../structures/directory.hpp"
+#include "../../logger/log.hpp"
+#include "../../configuration.hpp"
+
+namespace nmfs::caching_policies {
+using namespace nmfs::structures;
+
+template<typename indexing>
+window_tiny_lfu<indexing>::window_tiny_lfu(const mount_options& options)
+    : hold_closed_cache_for<indexing>(options),
+      capacity(options.cache_capacity),
+      window_capacity(std::max<size_t>(capacity * window_percentage / 100, 1)),
+      protected_capacity(capacity > window_capacity ? (capacity - window_capacity) * protected_percentage / 100 : 0),
+      sketch(capacity) {
+}
+
+template<typename indexing>
+bool window_tiny_lfu<indexing>::keep_cache(super_object<indexing>& context, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    return cache.open_count > 0 || residents.contains(&cache);
+}
+
+template<typename indexing>
+bool window_tiny_lfu<indexing>::keep_cache(super_object<indexing>& context, directory<indexing>& cache) {
+    return keep_cache(context, cache.directory_metadata);
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::inserted(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+
+    hit_counts.record_miss();
+    sketch.increment(node->path_hash);
+    window.entries.push_front(resident_entry {
+        .node = node,
+        .key = node->path_hash,
+        .cached_metadata = &cache,
+        .segment = segment_type::window,
+        .epoch = current_epoch(),
+        .pinned = false,
+    });
+    residents.insert_or_assign(&cache, window.entries.begin());
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::inserted(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    // Metadata of the directory is already inserted
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::accessed(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    auto iterator = residents.find(&cache);
+
+    hit_counts.record_hit();
+    if (iterator != residents.end()) {
+        auto entry = iterator->second;
+        uint64_t epoch = current_epoch();
+        // Touches of the epoch the entry was last counted in are made by the same scan
+        bool new_epoch = entry->epoch != epoch;
+
+        if (new_epoch) {
+            entry->epoch = epoch;
+            sketch.increment(entry->key);
+        }
+
+        if (entry->segment == segment_type::window || !new_epoch) {
+            move_to(entry, entry->segment);
+        } else {
+            move_to(entry, segment_type::protected_segment);
+            while (protected_segment.size() > protected_capacity && !protected_segment.entries.empty()) {
+                move_to(std::prev(protected_segment.entries.end()), segment_type::probation);
+            }
+        }
+    }
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::accessed(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    accessed(context, node, cache.directory_metadata);
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::erased(super_object<indexing>& context, path_node* node, metadata<indexing>& cache) {
+    auto lock = std::unique_lock(mutex);
+    auto iterator = residents.find(&cache);
+
+    // Entries evicted by victims() are already removed
+    if (iterator != residents.end()) {
+        evict(iterator->second);
+    }
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::erased(super_object<indexing>& context, path_node* node, directory<indexing>& cache) {
+    // Metadata of the directory is erased separately
+}
+
+template<typename indexing>
+bool window_tiny_lfu<indexing>::over_budget() const {
+    auto lock = std::unique_lock(mutex);
+    return window.size() + main_size() > capacity;
+}
+
+template<typename indexing>
+std::vector<path_node*> window_tiny_lfu<indexing>::victims(super_object<indexing>& context) {
+    auto lock = std::unique_lock(mutex);
+    std::vector<path_node*> result;
+    const size_t main_capacity = capacity - std::min(capacity, window_capacity);
+
+    unpin(window);
+    unpin(probation);
+    unpin(protected_segment);
+
+    // Entries leaving window are admitted without competition while main cache has room
+    while (window.size() > window_capacity && main_size() < main_capacity && !window.entries.empty()) {
+        move_to(std::prev(window.entries.end()), segment_type::probation);
+    }
+
+    while (window.size() + main_size() > capacity) {
+        auto victim = find_evictable(probation);
+        bool victim_found = victim != probation.entries.end();
+        if (!victim_found) {
+            victim = find_evictable(protected_segment);
+            victim_found = victim != protected_segment.entries.end();
+        }
+
+        auto candidate = window.size() > window_capacity ? find_evictable(window) : window.entries.end();
+        bool candidate_found = candidate != window.entries.end();
+
+        if (candidate_found && victim_found) {
+            // Admission filter: candidate replaces victim only if it is more popular
+            if (sketch.frequency(candidate->key) > sketch.frequency(victim->key)) {
+                result.push_back(evict(victim));
+                move_to(candidate, segment_type::probation);
+            } else {
+                result.push_back(evict(candidate));
+            }
+        } else if (victim_found) {
+            result.push_back(evict(victim));
+        } else if (candidate_found) {
+            result.push_back(evict(candidate));
+        } else if (auto window_victim = find_evictable(window); window_victim != window.entries.end()) {
+            result.push_back(evict(window_victim));
+        } else {
+            // Every entry is in use
+            break;
+        }
+    }
+
+    log::information(log_locations::cache_store_operation) << __func__ << "(): window = " << window.size() << ", probation = " << probation.size() << ", protected = " << protected_segment.size() << ", hit_ratio = " << hit_counts.hit_ratio() << ", victims = " << result.size() << '\n';
+    return result;
+}
+
+template<typename indexing>
+constexpr const hit_statistics& window_tiny_lfu<indexing>::statistics() const {
+    return hit_counts;
+}
+
+template<typename indexing>
+size_t window_tiny_lfu<indexing>::segment::size() const {
+    return entries.size() + pinned.size();
+}
+
+template<typename indexing>
+typename window_tiny_lfu<indexing>::segment& window_tiny_lfu<indexing>::segment_of(segment_type type) {
+    switch (type) {
+        case segment_type::window:
+            return window;
+        case segment_type::probation:
+            return probation;
+        default:
+            return protected_segment;
+    }
+}
+
+template<typename indexing>
+typename window_tiny_lfu<indexing>::resident_list& window_tiny_lfu<indexing>::list_of(const resident_entry& entry) {
+    auto& entry_segment = segment_of(entry.segment);
+    return entry.pinned ? entry_segment.pinned : entry_segment.entries;
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::move_to(typename resident_list::iterator iterator, segment_type destination) {
+    auto& destination_list = segment_of(destination).entries;
+    destination_list.splice(destination_list.begin(), list_of(*iterator), iterator);
+    iterator->segment = destination;
+    iterator->pinned = false;
+}
+
+template<typename indexing>
+size_t window_tiny_lfu<indexing>::main_size() const {
+    return probation.size() + protected_segment.size();
+}
+
+template<typename indexing>
+void window_tiny_lfu<indexing>::unpin(segment& target) {
+    for (auto iterator = target.pinned.begin(); iterator != target.pinned.end();) {
+        auto next = std::next(iterator);
+        if (iterator->cached_metadata->open_count == 0 && !iterator->cached_metadata->dirty) {
+            // Used until recently, so it returns as the most recently used entry
+            target.entries.splice(target.entries.begin(), target.pinned, iterator);
+            iterator->pinned = false;
+        }
+        iterator = next;
+    }
+}
+
+template<typename indexing>
+typename window_tiny_lfu<indexing>::resident_list::iterator window_tiny_lfu<indexing>::find_evictable(segment& target) {
+    // Opened or dirty entries can't be evicted by cache_store, so they are set aside instead of being scanned again
+    while (!target.entries.empty()) {
+        auto iterator = std::prev(target.entries.end());
+        if (iterator->cached_metadata->open_count == 0 && !iterator->cached_metadata->dirty) {
+            return iterator;
+        }
+        target.pinned.splice(target.pinned.begin(), target.entries, iterator);
+        iterator->pinned = true;
+    }
+    return target.entries.end();
+}
+
+template<typename indexing>
+path_node* window_tiny_lfu<indexing>::evict(typename resident_list::iterator iterator) {
+    path_node* node = iterator->node;
+
+    residents.erase(iterator->cached_metadata);
+    list_of(*iterator).erase(iterator);
+    return node;
+}
+
+template<typename indexing>
+uint64_t window_tiny_lfu<indexing>::current_epoch() {
+    return std::chrono::steady_clock::now().time_since_epoch() / configuration::cache_scan_epoch_duration;
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_CACHING_POLICY_WINDOW_TINY_LFU_IMPL_HPP
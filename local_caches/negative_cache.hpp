@@ -0,0 +1,203 @@
+#ifndef NMFS_LOCAL_CACHES_NEGATIVE_CACHE_HPP
+#define NMFS_LOCAL_CACHES_NEGATIVE_CACHE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include "../utils.hpp"
+#include "utils/path_trie.hpp"
+
+namespace nmfs {
+
+/**
+ * Bounded cache of paths known not to exist, keyed by parent directory node and file name
+ *
+ * Entries expire after valid_duration. As every entry lives for the same duration, insertion order is also
+ * expiration order, so the oldest entry is evicted first when the cache is full.
+ *
+ * Every erase and clear advances a generation, and a lookup inserts its result only if the generation is the same as
+ * when it started. So a lookup racing with a create never leaves the created path remembered as nonexistent.
+ */
+class negative_cache {
+public:
+    inline negative_cache(path_trie& paths, size_t capacity, std::chrono::system_clock::duration valid_duration);
+    negative_cache(const negative_cache&) = delete;
+    inline ~negative_cache();
+
+    [[nodiscard]] inline bool contains(std::string_view path) const;
+    /**
+     * Generation to be passed to insert, taken before a lookup
+     */
+    [[nodiscard]] inline uint64_t generation() const;
+    /**
+     * Remember the path, unless any entry is erased after lookup_generation was taken
+     */
+    inline void insert(std::string_view path, uint64_t lookup_generation);
+    inline void erase(std::string_view path);
+    inline void clear();
+    [[nodiscard]] constexpr bool enabled() const;
+
+private:
+    using key_type = std::pair<path_node*, std::string>;
+    using lookup_key_type = std::pair<path_node*, std::string_view>;
+
+    struct key_hash {
+        using is_transparent = void;
+
+        inline size_t operator()(const lookup_key_type& key) const;
+        inline size_t operator()(const key_type& key) const;
+    };
+
+    struct key_equal {
+        using is_transparent = void;
+
+        template<typename left_type, typename right_type>
+        inline bool operator()(const left_type& left, const right_type& right) const;
+    };
+
+    struct entry {
+        key_type key;
+        std::chrono::system_clock::time_point expiration;
+    };
+
+    path_trie& paths;
+    const size_t capacity;
+    const std::chrono::system_clock::duration valid_duration;
+    std::list<entry> entries; // Oldest first
+    std::unordered_map<key_type, std::list<entry>::iterator, key_hash, key_equal> index;
+    mutable std::shared_mutex mutex;
+    std::atomic<uint64_t> current_generation = 0;
+
+    inline void erase(std::list<entry>::iterator iterator);
+    inline void evict_expired(std::chrono::system_clock::time_point now);
+};
+
+inline negative_cache::negative_cache(path_trie& paths, size_t capacity, std::chrono::system_clock::duration valid_duration)
+    : paths(paths),
+      capacity(capacity),
+      valid_duration(valid_duration) {
+}
+
+inline negative_cache::~negative_cache() {
+    clear();
+}
+
+inline bool negative_cache::contains(std::string_view path) const {
+    if (!enabled()) {
+        return false;
+    }
+
+    path_node* parent = paths.find(get_parent_directory(path));
+    if (parent == nullptr) {
+        return false;
+    }
+
+    auto lock = std::shared_lock(mutex);
+    auto iterator = index.find(lookup_key_type(parent, get_filename(path)));
+    return iterator != index.end() && iterator->second->expiration >= std::chrono::system_clock::now();
+}
+
+inline uint64_t negative_cache::generation() const {
+    return current_generation;
+}
+
+inline void negative_cache::insert(std::string_view path, uint64_t lookup_generation) {
+    if (!enabled()) {
+        return;
+    }
+
+    auto now = std::chrono::system_clock::now();
+    auto lock = std::unique_lock(mutex);
+    // Advanced before an erase takes the lock, so an entry inserted after this check is erased by it
+    if (current_generation != lookup_generation) {
+        return;
+    }
+    path_node* parent = paths.intern(get_parent_directory(path));
+    std::string_view file_name = get_filename(path);
+    auto iterator = index.find(lookup_key_type(parent, file_name));
+
+    if (iterator != index.end()) {
+        erase(iterator->second);
+    }
+    evict_expired(now);
+    while (entries.size() >= capacity) {
+        erase(entries.begin());
+    }
+
+    entries.push_back(entry {
+        .key = key_type(parent, std::string(file_name)),
+        .expiration = now + valid_duration,
+    });
+    index.emplace(entries.back().key, std::prev(entries.end()));
+}
+
+inline void negative_cache::erase(std::string_view path) {
+    if (!enabled()) {
+        return;
+    }
+
+    current_generation++;
+
+    path_node* parent = paths.find(get_parent_directory(path));
+    if (parent == nullptr) {
+        return;
+    }
+
+    auto lock = std::unique_lock(mutex);
+    auto iterator = index.find(lookup_key_type(parent, get_filename(path)));
+    if (iterator != index.end()) {
+        erase(iterator->second);
+    }
+}
+
+inline void negative_cache::clear() {
+    current_generation++;
+    auto lock = std::unique_lock(mutex);
+
+    while (!entries.empty()) {
+        erase(entries.begin());
+    }
+}
+
+constexpr bool negative_cache::enabled() const {
+    return capacity > 0 && valid_duration > std::chrono::system_clock::duration::zero();
+}
+
+inline void negative_cache::erase(std::list<entry>::iterator iterator) {
+    path_node* parent = iterator->key.first;
+
+    index.erase(index.find(iterator->key));
+    entries.erase(iterator);
+    paths.release(parent);
+}
+
+inline void negative_cache::evict_expired(std::chrono::system_clock::time_point now) {
+    while (!entries.empty() && entries.front().expiration < now) {
+        erase(entries.begin());
+    }
+}
+
+inline size_t negative_cache::key_hash::operator()(const lookup_key_type& key) const {
+    return std::hash<path_node*>()(key.first) ^ (std::hash<std::string_view>()(key.second) << 1);
+}
+
+inline size_t negative_cache::key_hash::operator()(const key_type& key) const {
+    return operator()(lookup_key_type(key.first, key.second));
+}
+
+template<typename left_type, typename right_type>
+inline bool negative_cache::key_equal::operator()(const left_type& left, const right_type& right) const {
+    return left.first == right.first && std::string_view(left.second) == std::string_view(right.second);
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_NEGATIVE_CACHE_HPP
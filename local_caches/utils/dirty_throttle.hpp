@@ -0,0 +1,107 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_DIRTY_THROTTLE_HPP
+#define NMFS_LOCAL_CACHES_UTILS_DIRTY_THROTTLE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include "../../configuration.hpp"
+
+namespace nmfs {
+
+/**
+ * Number and size of dirty entries, which delays writers progressively as they grow between soft and hard limits
+ *
+ * Writers are not delayed under the soft limits. Between them, each writer sleeps for a pause growing quadratically up
+ * to configuration::dirty_throttle_max_pause, and at a hard limit writers wait until flushes bring dirty entries under
+ * it. So writers slow down to the rate of flushes instead of stopping at once.
+ */
+class dirty_throttle {
+public:
+    inline void charge(size_t entries, size_t bytes);
+    /**
+     * Remove flushed entries, waking writers waiting at a hard limit once under it
+     */
+    inline void discharge(size_t entries, size_t bytes);
+    [[nodiscard]] inline bool over_soft_limit();
+    /**
+     * Fraction of a soft limit filled by dirty entries, whichever is fuller, up to 1
+     */
+    [[nodiscard]] inline double fill();
+    /**
+     * Delay a writer according to dirty entries, which is called without holding any lock of an entry
+     */
+    inline void balance();
+
+private:
+    size_t dirty_entries = 0;
+    size_t dirty_bytes = 0;
+    std::mutex mutex;
+    std::condition_variable under_hard_limit;
+
+    /**
+     * Progress from soft limits to hard limits of whichever is further, 0 under soft limits and 1 at a hard limit
+     */
+    [[nodiscard]] inline double position() const;
+};
+
+inline void dirty_throttle::charge(size_t entries, size_t bytes) {
+    auto lock = std::unique_lock(mutex);
+    dirty_entries += entries;
+    dirty_bytes += bytes;
+}
+
+inline void dirty_throttle::discharge(size_t entries, size_t bytes) {
+    {
+        auto lock = std::unique_lock(mutex);
+        dirty_entries -= std::min(entries, dirty_entries);
+        dirty_bytes -= std::min(bytes, dirty_bytes);
+        if (position() >= 1) {
+            return;
+        }
+    }
+    under_hard_limit.notify_all();
+}
+
+inline bool dirty_throttle::over_soft_limit() {
+    auto lock = std::unique_lock(mutex);
+    return position() > 0;
+}
+
+inline double dirty_throttle::fill() {
+    auto lock = std::unique_lock(mutex);
+    return std::min(1.0, std::max(static_cast<double>(dirty_entries) / static_cast<double>(configuration::dirty_entries_soft_limit),
+                                  static_cast<double>(dirty_bytes) / static_cast<double>(configuration::dirty_bytes_soft_limit)));
+}
+
+inline void dirty_throttle::balance() {
+    auto lock = std::unique_lock(mutex);
+    double current_position = position();
+
+    if (current_position >= 1) {
+        under_hard_limit.wait(lock, [this]() {
+            return position() < 1;
+        });
+    } else if (current_position > 0) {
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::microseconds>(configuration::dirty_throttle_max_pause * current_position * current_position));
+    }
+}
+
+inline double dirty_throttle::position() const {
+    auto progress = [](size_t value, size_t soft_limit, size_t hard_limit) {
+        if (value <= soft_limit) {
+            return 0.0;
+        }
+        return std::min(1.0, static_cast<double>(value - soft_limit) / static_cast<double>(hard_limit - soft_limit));
+    };
+
+    return std::max(progress(dirty_entries, configuration::dirty_entries_soft_limit, configuration::dirty_entries_hard_limit),
+                    progress(dirty_bytes, configuration::dirty_bytes_soft_limit, configuration::dirty_bytes_hard_limit));
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_DIRTY_THROTTLE_HPP
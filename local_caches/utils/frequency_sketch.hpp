@@ -0,0 +1,88 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_FREQUENCY_SKETCH_HPP
+#define NMFS_LOCAL_CACHES_UTILS_FREQUENCY_SKETCH_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace nmfs {
+
+/**
+ * Count-min sketch estimating recent access frequency of keys, as used by TinyLFU admission
+ *
+ * Counters saturate at max_frequency, and all of them are halved after every sample_size increments so that old
+ * popularity fades out.
+ */
+class frequency_sketch {
+public:
+    static constexpr uint8_t max_frequency = 15;
+
+    inline explicit frequency_sketch(size_t capacity);
+
+    inline void increment(uint64_t hash);
+    [[nodiscard]] inline uint8_t frequency(uint64_t hash) const;
+
+private:
+    static constexpr size_t depth = 4;
+    static constexpr std::array<uint64_t, depth> seeds = {
+        0xc3a5c85c97cb3127, 0xb492b66fbe98f273, 0x9ae16a3b2f90404f, 0xcbf29ce484222325,
+    };
+
+    const size_t width;
+    const size_t sample_size;
+    size_t additions = 0;
+    std::vector<uint8_t> counters;
+
+    [[nodiscard]] inline size_t index_of(uint64_t hash, size_t row) const;
+    inline void halve();
+};
+
+inline frequency_sketch::frequency_sketch(size_t capacity)
+    : width(std::bit_ceil(std::max<size_t>(capacity, 16))),
+      sample_size(10 * width),
+      counters(depth * width, 0) {
+}
+
+inline void frequency_sketch::increment(uint64_t hash) {
+    bool incremented = false;
+
+    for (size_t row = 0; row < depth; row++) {
+        uint8_t& counter = counters[index_of(hash, row)];
+        if (counter < max_frequency) {
+            counter++;
+            incremented = true;
+        }
+    }
+
+    if (incremented && ++additions >= sample_size) {
+        halve();
+    }
+}
+
+inline uint8_t frequency_sketch::frequency(uint64_t hash) const {
+    uint8_t result = max_frequency;
+
+    for (size_t row = 0; row < depth; row++) {
+        result = std::min(result, counters[index_of(hash, row)]);
+    }
+    return result;
+}
+
+inline size_t frequency_sketch::index_of(uint64_t hash, size_t row) const {
+    uint64_t mixed = (hash + seeds[row]) * seeds[row];
+    mixed ^= mixed >> 32;
+    return row * width + (mixed & (width - 1));
+}
+
+inline void frequency_sketch::halve() {
+    for (uint8_t& counter: counters) {
+        counter >>= 1;
+    }
+    additions /= 2;
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_FREQUENCY_SKETCH_HPP
@@ -0,0 +1,52 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_HIT_STATISTICS_HPP
+#define NMFS_LOCAL_CACHES_UTILS_HIT_STATISTICS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace nmfs {
+
+/**
+ * Hit and miss counters of a cache, safe to update from multiple threads
+ */
+class hit_statistics {
+public:
+    inline void record_hit();
+    inline void record_miss();
+    [[nodiscard]] inline uint64_t hits() const;
+    [[nodiscard]] inline uint64_t misses() const;
+    /**
+     * @return Ratio of hits among all lookups, or 0 if there was no lookup
+     */
+    [[nodiscard]] inline double hit_ratio() const;
+
+private:
+    std::atomic<uint64_t> hit_count = 0;
+    std::atomic<uint64_t> miss_count = 0;
+};
+
+inline void hit_statistics::record_hit() {
+    hit_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void hit_statistics::record_miss() {
+    miss_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline uint64_t hit_statistics::hits() const {
+    return hit_count.load(std::memory_order_relaxed);
+}
+
+inline uint64_t hit_statistics::misses() const {
+    return miss_count.load(std::memory_order_relaxed);
+}
+
+inline double hit_statistics::hit_ratio() const {
+    uint64_t hit = hits();
+    uint64_t lookup = hit + misses();
+    return lookup > 0 ? static_cast<double>(hit) / static_cast<double>(lookup) : 0;
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_HIT_STATISTICS_HPP
@@ -0,0 +1,85 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_MEMORY_PRESSURE_HPP
+#define NMFS_LOCAL_CACHES_UTILS_MEMORY_PRESSURE_HPP
+
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unistd.h>
+
+namespace nmfs {
+
+/**
+ * Reader of pressure stall information (PSI) for memory
+ *
+ * Pressure of the cgroup this process belongs to is used if cgroup v2 is available, and system-wide pressure otherwise.
+ */
+class memory_pressure {
+public:
+    struct averages {
+        /**
+         * Percentage of time in last 10 seconds that some tasks were stalled on memory
+         */
+        double some_average_10 = 0;
+        /**
+         * Percentage of time in last 10 seconds that all tasks were stalled on memory
+         */
+        double full_average_10 = 0;
+    };
+
+    inline memory_pressure();
+
+    [[nodiscard]] inline std::optional<averages> read() const;
+
+private:
+    std::string pressure_file_path;
+};
+
+inline memory_pressure::memory_pressure() {
+    auto cgroup_file = std::ifstream("/proc/self/cgroup");
+    std::string line;
+
+    while (std::getline(cgroup_file, line)) {
+        // cgroup v2 entry is "0::<path>"
+        if (line.starts_with("0::")) {
+            std::string path = "/sys/fs/cgroup" + line.substr(3) + "/memory.pressure";
+            if (access(path.c_str(), R_OK) == 0) {
+                pressure_file_path = std::move(path);
+                return;
+            }
+        }
+    }
+
+    if (access("/proc/pressure/memory", R_OK) == 0) {
+        pressure_file_path = "/proc/pressure/memory";
+    }
+}
+
+inline std::optional<memory_pressure::averages> memory_pressure::read() const {
+    if (pressure_file_path.empty()) {
+        return std::nullopt;
+    }
+
+    auto pressure_file = std::ifstream(pressure_file_path);
+    auto result = averages {};
+    bool parsed = false;
+    std::string line;
+
+    while (std::getline(pressure_file, line)) {
+        double value;
+
+        if (std::sscanf(line.c_str(), "some avg10=%lf", &value) == 1) {
+            result.some_average_10 = value;
+            parsed = true;
+        } else if (std::sscanf(line.c_str(), "full avg10=%lf", &value) == 1) {
+            result.full_average_10 = value;
+            parsed = true;
+        }
+    }
+
+    return parsed ? std::optional(result) : std::nullopt;
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_MEMORY_PRESSURE_HPP
@@ -0,0 +1,267 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_PATH_TRIE_HPP
+#define NMFS_LOCAL_CACHES_UTILS_PATH_TRIE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../../utils.hpp"
+
+namespace nmfs {
+
+class path_trie;
+
+/**
+ * A path component interned in path_trie
+ *
+ * Each node stores only its own name, so memory is proportional to the number of unique components.
+ */
+class path_node {
+public:
+    path_node* parent;
+    std::string name;
+    /**
+     * Hash of the whole path, derived from the hash of the parent, so it is the same whenever the path is interned again
+     *
+     * A node moved by path_trie::move keeps the hash of the path it was interned with.
+     */
+    const size_t path_hash;
+
+    inline path_node(path_node* parent, std::string name);
+    path_node(const path_node&) = delete;
+    path_node(path_node&&) = delete;
+
+    [[nodiscard]] inline std::string path() const;
+    [[nodiscard]] inline path_node* find_child(std::string_view child_name) const;
+    [[nodiscard]] constexpr bool is_root() const;
+
+private:
+    friend class path_trie;
+
+    /**
+     * Keys are views into the name of each child, which lives as long as the child
+     */
+    std::unordered_map<std::string_view, std::unique_ptr<path_node>> children;
+    size_t reference_count = 0;
+};
+
+/**
+ * Interned path table used as the key space of cache_store
+ *
+ * A node is kept alive while it is referenced by a cache entry or has children.
+ */
+class path_trie {
+public:
+    inline path_trie();
+
+    /**
+     * Find the node of the given path without creating it
+     * @return Node of the path, or nullptr if any component is not interned
+     */
+    [[nodiscard]] inline path_node* find(std::string_view path) const;
+    /**
+     * Find or create the node of the given path, and increase its reference count
+     */
+    inline path_node* intern(std::string_view path);
+    /**
+     * Decrease reference count of the node, and remove it and its unused ancestors
+     */
+    inline void release(path_node* node);
+    /**
+     * Move the node of old_path, with nodes under it, to new_path, so they keep their addresses
+     *
+     * A node already at new_path is detached with nodes under it, so it is not found any more and is removed once
+     * released.
+     * @return false if old_path is not interned
+     */
+    inline bool move(std::string_view old_path, std::string_view new_path);
+    [[nodiscard]] constexpr size_t size() const;
+
+private:
+    path_node root;
+    /**
+     * Parent of detached nodes, each named after its address
+     */
+    path_node detached;
+    size_t number_of_nodes;
+    mutable std::shared_mutex mutex;
+
+    [[nodiscard]] inline path_node* find_locked(std::string_view path) const;
+    /**
+     * Remove the node if it is not referenced and has no children, and then its unused ancestors
+     */
+    inline void remove_unused(path_node* node);
+
+    template<typename function_type>
+    static inline void for_each_component(std::string_view path, function_type function);
+};
+
+inline path_node::path_node(path_node* parent, std::string name)
+    : parent(parent),
+      name(std::move(name)),
+      path_hash(parent == nullptr ? 0 : parent->path_hash * 0x100000001b3 ^ std::hash<std::string>()(this->name)) {
+}
+
+inline std::string path_node::path() const {
+    if (is_root()) {
+        return std::string(1, path_delimiter);
+    } else {
+        std::vector<const path_node*> nodes;
+        size_t length = 0;
+
+        for (const path_node* node = this; !node->is_root(); node = node->parent) {
+            nodes.push_back(node);
+            length += node->name.size() + 1;
+        }
+
+        std::string result;
+        result.reserve(length);
+        for (auto iterator = nodes.rbegin(); iterator != nodes.rend(); iterator++) {
+            result += path_delimiter;
+            result += (*iterator)->name;
+        }
+        return result;
+    }
+}
+
+inline path_node* path_node::find_child(std::string_view child_name) const {
+    auto iterator = children.find(child_name);
+    return iterator != children.end() ? iterator->second.get() : nullptr;
+}
+
+constexpr bool path_node::is_root() const {
+    return parent == nullptr;
+}
+
+inline path_trie::path_trie()
+    : root(nullptr, std::string()),
+      detached(nullptr, std::string()),
+      number_of_nodes(1) {
+}
+
+inline path_node* path_trie::find(std::string_view path) const {
+    auto lock = std::shared_lock(mutex);
+    return find_locked(path);
+}
+
+inline path_node* path_trie::find_locked(std::string_view path) const {
+    auto node = const_cast<path_node*>(&root);
+
+    for_each_component(path, [&node](std::string_view component) {
+        if (node != nullptr) {
+            node = node->find_child(component);
+        }
+    });
+    return node;
+}
+
+inline path_node* path_trie::intern(std::string_view path) {
+    auto lock = std::unique_lock(mutex);
+    path_node* node = &root;
+
+    for_each_component(path, [this, &node](std::string_view component) {
+        path_node* child = node->find_child(component);
+
+        if (child == nullptr) {
+            auto new_child = std::make_unique<path_node>(node, std::string(component));
+            child = new_child.get();
+            node->children.emplace(std::string_view(child->name), std::move(new_child));
+            number_of_nodes++;
+        }
+        node = child;
+    });
+
+    node->reference_count++;
+    return node;
+}
+
+inline void path_trie::release(path_node* node) {
+    auto lock = std::unique_lock(mutex);
+
+    node->reference_count--;
+    remove_unused(node);
+}
+
+inline bool path_trie::move(std::string_view old_path, std::string_view new_path) {
+    auto lock = std::unique_lock(mutex);
+    path_node* node = find_locked(old_path);
+
+    if (node == nullptr || node->is_root()) {
+        return false;
+    }
+
+    path_node* new_parent = &root;
+    std::string_view new_name;
+    for_each_component(new_path, [this, &new_parent, &new_name](std::string_view component) {
+        if (!new_name.empty()) {
+            path_node* child = new_parent->find_child(new_name);
+            if (child == nullptr) {
+                auto new_child = std::make_unique<path_node>(new_parent, std::string(new_name));
+                child = new_child.get();
+                new_parent->children.emplace(std::string_view(child->name), std::move(new_child));
+                number_of_nodes++;
+            }
+            new_parent = child;
+        }
+        new_name = component;
+    });
+
+    if (new_name.empty()) {
+        return false;
+    } else if (path_node* existing = new_parent->find_child(new_name); existing == node) {
+        return true;
+    } else if (existing != nullptr) {
+        auto existing_owner = std::move(new_parent->children.extract(existing->name).mapped());
+        existing->name = std::to_string(reinterpret_cast<uintptr_t>(existing));
+        existing->parent = &detached;
+        detached.children.emplace(std::string_view(existing->name), std::move(existing_owner));
+        remove_unused(existing);
+    }
+
+    // Keys of children are views into names, so the node is taken out before its name changes
+    path_node* old_parent = node->parent;
+    auto owner = std::move(old_parent->children.extract(node->name).mapped());
+    node->name = std::string(new_name);
+    node->parent = new_parent;
+    new_parent->children.emplace(std::string_view(node->name), std::move(owner));
+    remove_unused(old_parent);
+    return true;
+}
+
+inline void path_trie::remove_unused(path_node* node) {
+    while (!node->is_root() && node->reference_count == 0 && node->children.empty()) {
+        path_node* parent = node->parent;
+        parent->children.erase(parent->children.find(node->name)); // node is destroyed here
+        number_of_nodes--;
+        node = parent;
+    }
+}
+
+constexpr size_t path_trie::size() const {
+    return number_of_nodes;
+}
+
+template<typename function_type>
+inline void path_trie::for_each_component(std::string_view path, function_type function) {
+    size_t begin = 0;
+
+    while (begin < path.size()) {
+        size_t end = path.find(path_delimiter, begin);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        if (end > begin) {
+            function(path.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_PATH_TRIE_HPP
@@ -0,0 +1,100 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_RENAME_JOURNAL_HPP
+#define NMFS_LOCAL_CACHES_UTILS_RENAME_JOURNAL_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../../configuration.hpp"
+#include "../../kv_backends/kv_backend.hpp"
+#include "../../kv_backends/exceptions/key_does_not_exist.hpp"
+#include "../../memory_slices/borrower_slice.hpp"
+#include "../../memory_slices/owner_slice.hpp"
+
+namespace nmfs {
+
+/**
+ * Renames of directories in progress, kept in the ordered map of a backend object
+ *
+ * A rename is recorded before its subtree is moved and forgotten after entries of its parents are changed, so one
+ * interrupted by a crash is found and resumed on next mount. Each record is keyed by the old path and holds the new
+ * path.
+ */
+class rename_journal {
+public:
+    struct record {
+        std::string old_path;
+        std::string new_path;
+    };
+
+    explicit inline rename_journal(kv_backends::kv_backend& backend);
+
+    inline void begin(std::string_view old_path, std::string_view new_path);
+    inline void end(std::string_view old_path);
+    /**
+     * Renames begun and not ended, in the order of old paths
+     */
+    [[nodiscard]] inline std::vector<record> pending() const;
+
+private:
+    /**
+     * Paths of every indexing type begin with a delimiter, so no file is stored under this key
+     */
+    static constexpr std::string_view journal_key = "nmfs.rename_journal";
+
+    kv_backends::kv_backend& backend;
+};
+
+inline rename_journal::rename_journal(kv_backends::kv_backend& backend)
+    : backend(backend) {
+}
+
+inline void rename_journal::begin(std::string_view old_path, std::string_view new_path) {
+    DECLARE_CONST_BORROWER_SLICE(key, journal_key.data(), journal_key.size());
+    DECLARE_CONST_BORROWER_SLICE(value, new_path.data(), new_path.size());
+    std::map<std::string, owner_slice> values;
+
+    values.emplace(std::string(old_path), owner_slice(value));
+    backend.update_map(key, values, {});
+}
+
+inline void rename_journal::end(std::string_view old_path) {
+    DECLARE_CONST_BORROWER_SLICE(key, journal_key.data(), journal_key.size());
+
+    backend.update_map(key, {}, {std::string(old_path)});
+}
+
+inline std::vector<rename_journal::record> rename_journal::pending() const {
+    DECLARE_CONST_BORROWER_SLICE(key, journal_key.data(), journal_key.size());
+    std::map<std::string, owner_slice> values;
+    bool more = true;
+
+    try {
+        while (more) {
+            size_t previous_size = values.size();
+            std::string after = values.empty() ? std::string() : values.rbegin()->first;
+
+            more = backend.list_map(key, after, configuration::directory_listing_size, values);
+            if (values.size() == previous_size) {
+                break;
+            }
+        }
+    } catch (kv_backends::exceptions::key_does_not_exist&) {
+        // Nothing was ever renamed
+    }
+
+    std::vector<record> records;
+    records.reserve(values.size());
+    for (const auto& [old_path, new_path]: values) {
+        records.push_back(record {
+            .old_path = old_path,
+            .new_path = std::string(reinterpret_cast<const char*>(new_path.data()), new_path.size()),
+        });
+    }
+    return records;
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_RENAME_JOURNAL_HPP
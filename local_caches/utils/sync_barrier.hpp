@@ -0,0 +1,61 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_SYNC_BARRIER_HPP
+#define NMFS_LOCAL_CACHES_UTILS_SYNC_BARRIER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace nmfs {
+
+/**
+ * Coalesces concurrent requests of a sync into as few syncs as possible
+ *
+ * A request is satisfied by a sync started after it. One caller runs the sync for every request made before it
+ * starts, while later requests wait and are served together by the next one.
+ */
+class sync_barrier {
+public:
+    template<typename function_type>
+    inline void wait(function_type sync);
+
+private:
+    uint64_t requested = 0;
+    uint64_t completed = 0;
+    bool running = false;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+};
+
+template<typename function_type>
+inline void sync_barrier::wait(function_type sync) {
+    auto lock = std::unique_lock(mutex);
+    uint64_t ticket = ++requested;
+
+    while (completed < ticket) {
+        if (running) {
+            wakeup.wait(lock);
+            continue;
+        }
+
+        uint64_t target = requested;
+        running = true;
+        lock.unlock();
+        try {
+            sync();
+        } catch (...) {
+            // Waiters retry with a sync of their own
+            lock.lock();
+            running = false;
+            wakeup.notify_all();
+            throw;
+        }
+        lock.lock();
+        running = false;
+        completed = target;
+        wakeup.notify_all();
+    }
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_SYNC_BARRIER_HPP
@@ -0,0 +1,171 @@
+#ifndef NMFS_LOCAL_CACHES_UTILS_WORK_QUEUE_HPP
+#define NMFS_LOCAL_CACHES_UTILS_WORK_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nmfs {
+
+/**
+ * Tasks run by a bounded number of worker threads
+ *
+ * Tasks are submitted to a task_group, and a thread waiting for a group runs queued tasks of the group until it is
+ * finished. So a task may submit tasks and wait for them without holding a worker idle, nested groups never deadlock,
+ * and a waiter nests only as deep as the groups it waits for.
+ */
+class work_queue {
+public:
+    /**
+     * Tasks waited for together, whose first exception is rethrown by wait
+     */
+    class task_group {
+    public:
+        task_group() = default;
+        task_group(const task_group&) = delete;
+
+    private:
+        friend class work_queue;
+
+        size_t pending = 0;
+        std::exception_ptr exception;
+        std::queue<std::function<void()>> tasks;
+        /**
+         * Position in ready groups of work_queue, while any task is queued
+         */
+        std::list<task_group*>::iterator position;
+        /**
+         * Notified when a task of this group is submitted or finished
+         */
+        std::condition_variable wakeup;
+    };
+
+    explicit inline work_queue(size_t number_of_workers);
+    work_queue(const work_queue&) = delete;
+    inline ~work_queue();
+
+    inline void submit(task_group& group, std::function<void()> task);
+    /**
+     * Run queued tasks of the group until every task of it is finished
+     */
+    inline void wait(task_group& group);
+
+private:
+    /**
+     * Groups with queued tasks, which workers take tasks from in turn
+     */
+    std::list<task_group*> ready_groups;
+    std::mutex mutex;
+    /**
+     * Notified when a task is submitted
+     */
+    std::condition_variable wakeup;
+    bool stop = false;
+    std::vector<std::thread> workers;
+
+    inline void worker_main();
+    /**
+     * Run the first queued task of the group, whose lock is held on call and on return
+     */
+    inline void run_next(task_group& group, std::unique_lock<std::mutex>& lock);
+};
+
+inline work_queue::work_queue(size_t number_of_workers) {
+    workers.reserve(number_of_workers);
+    for (size_t i = 0; i < number_of_workers; i++) {
+        workers.emplace_back(&work_queue::worker_main, this);
+    }
+}
+
+inline work_queue::~work_queue() {
+    {
+        auto lock = std::unique_lock(mutex);
+        stop = true;
+    }
+    wakeup.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+inline void work_queue::submit(task_group& group, std::function<void()> task) {
+    {
+        auto lock = std::unique_lock(mutex);
+        group.pending++;
+        if (group.tasks.empty()) {
+            group.position = ready_groups.insert(ready_groups.end(), &group);
+        }
+        group.tasks.push(std::move(task));
+        group.wakeup.notify_one();
+    }
+    wakeup.notify_one();
+}
+
+inline void work_queue::wait(task_group& group) {
+    auto lock = std::unique_lock(mutex);
+
+    while (group.pending > 0) {
+        if (!group.tasks.empty()) {
+            run_next(group, lock);
+        } else {
+            group.wakeup.wait(lock);
+        }
+    }
+
+    if (group.exception) {
+        std::rethrow_exception(std::exchange(group.exception, nullptr));
+    }
+}
+
+inline void work_queue::worker_main() {
+    auto lock = std::unique_lock(mutex);
+
+    while (true) {
+        wakeup.wait(lock, [this]() {
+            return stop || !ready_groups.empty();
+        });
+        if (ready_groups.empty()) {
+            return;
+        }
+        task_group& group = *ready_groups.front();
+        // Moved to the back, so groups submitted together share workers
+        ready_groups.splice(ready_groups.end(), ready_groups, ready_groups.begin());
+        run_next(group, lock);
+    }
+}
+
+inline void work_queue::run_next(task_group& group, std::unique_lock<std::mutex>& lock) {
+    auto next = std::move(group.tasks.front());
+    group.tasks.pop();
+    if (group.tasks.empty()) {
+        ready_groups.erase(group.position);
+    }
+    lock.unlock();
+
+    std::exception_ptr exception;
+    try {
+        next();
+    } catch (...) {
+        exception = std::current_exception();
+    }
+
+    lock.lock();
+    if (exception && !group.exception) {
+        group.exception = exception;
+    }
+    // Group may be destroyed by its waiter once the lock is released
+    if (--group.pending == 0) {
+        group.wakeup.notify_all();
+    }
+}
+
+}
+
+#endif //NMFS_LOCAL_CACHES_UTILS_WORK_QUEUE_HPP
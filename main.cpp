@@ -1,10 +1,71 @@
+#include <iostream>
+#include <string_view>
 #include "main.hpp"
 #include "fuse_operations.hpp"
+#include "mount_options.hpp"
+#include "exceptions/invalid_mount_option.hpp"
+
+enum option_key {
+    indexing_option,
+    caching_policy_option,
+    directory_storage_option,
+    metadata_journal_option,
+    write_ahead_log_option,
+};
+
+static const struct fuse_opt option_specification[] = {
+    FUSE_OPT_KEY("indexing=%s", indexing_option),
+    FUSE_OPT_KEY("cache=%s", caching_policy_option),
+    FUSE_OPT_KEY("directory=%s", directory_storage_option),
+    FUSE_OPT_KEY("journal=%s", metadata_journal_option),
+    FUSE_OPT_KEY("wal=%s", write_ahead_log_option),
+    FUSE_OPT_END,
+};
+
+static int process_option(void* data, const char* argument, int key, struct fuse_args* arguments) {
+    auto& options = *static_cast<nmfs::mount_options*>(data);
+    auto value = std::string_view(argument);
+    value.remove_prefix(value.find('=') + 1);
+
+    try {
+        switch (key) {
+            case indexing_option:
+                options.set_indexing(value);
+                return 0;
+            case caching_policy_option:
+                options.set_caching_policy(value);
+                return 0;
+            case directory_storage_option:
+                options.set_directory_storage(value);
+                return 0;
+            case metadata_journal_option:
+                options.set_metadata_journal(value);
+                return 0;
+            case write_ahead_log_option:
+                options.set_write_ahead_log(value);
+                return 0;
+            default:
+                // Pass other options to fuse
+                return 1;
+        }
+    } catch (nmfs::exceptions::invalid_mount_option& e) {
+        std::cerr << e.what() << '\n';
+        return -1;
+    }
+}
 
 int main(int argc, char* argv[]) {
+    struct fuse_args arguments = FUSE_ARGS_INIT(argc, argv);
+    nmfs::mount_options options;
     fuse_operations fops;
 
-    fops = nmfs::fuse_operations::get_fuse_ops();
+    if (fuse_opt_parse(&arguments, &options, option_specification, process_option) == -1) {
+        return 1;
+    }
+
+    fops = nmfs::fuse_operations::get_fuse_ops(options);
 
-    return fuse_main(argc, argv, &fops, NULL);
+    int result = fuse_main(arguments.argc, arguments.argv, &fops, &options);
+    fuse_opt_free_args(&arguments);
+    return result;
 }
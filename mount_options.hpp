@@ -0,0 +1,208 @@
+#ifndef NMFS__MOUNT_OPTIONS_HPP
+#define NMFS__MOUNT_OPTIONS_HPP
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "configuration.hpp"
+#include "exceptions/invalid_mount_option.hpp"
+
+namespace nmfs {
+
+/**
+ * Options selecting indexing type, caching policy and directory storage of a mount
+ *
+ * They are given as "-o indexing=<type>,cache=<policy>[:<argument>],directory=<storage>,journal=<on|off>,
+ * wal=<directory|off>". Every combination is compiled in, and the matching specialization is selected once at start up.
+ */
+struct mount_options {
+    enum class indexing_type {
+        custom,
+        full_path,
+        /**
+         * Custom indexing with attributes of regular files in directory entries
+         */
+        inline_attributes,
+        /**
+         * Directories and regular files keyed by UUIDs in their parent entries, so renaming moves no object
+         */
+        inode,
+    };
+
+    enum class caching_policy_type {
+        /**
+         * "ttl[:<seconds>]" - hold_closed_cache_for
+         */
+        hold_closed_cache_for,
+        /**
+         * "last_close" - evict_on_last_close
+         */
+        evict_on_last_close,
+        /**
+         * "memory[:<MiB>]" - evict_over_memory_budget
+         */
+        evict_over_memory_budget,
+        /**
+         * "arc[:<entries>]" - adaptive_replacement
+         */
+        adaptive_replacement,
+        /**
+         * "tinylfu[:<entries>]" - window_tiny_lfu
+         */
+        window_tiny_lfu,
+    };
+
+    enum class directory_storage_type {
+        /**
+         * "object" - Each directory fragment is a serialized object, rewritten when any entry changes
+         */
+        object,
+        /**
+         * "omap" - Each entry is a value in the ordered map of its fragment, so changing an entry writes only it
+         */
+        ordered_map,
+    };
+
+    indexing_type indexing = indexing_type::custom;
+    caching_policy_type caching_policy = caching_policy_type::hold_closed_cache_for;
+    std::chrono::seconds cache_valid_duration = configuration::cache_valid_duration;
+    size_t cache_capacity = configuration::cache_capacity;
+    size_t cache_memory_budget = configuration::cache_memory_budget;
+    directory_storage_type directory_storage = directory_storage_type::object;
+    /**
+     * Whether small values such as metadata are appended to a journal and written to their objects in batches
+     */
+    bool metadata_journal = true;
+    /**
+     * Directory on a local device where writes are logged before they are written to the backend, empty if they are
+     * written to the backend directly
+     */
+    std::string write_ahead_log_directory;
+
+    inline mount_options();
+
+    /**
+     * @param value Value of "indexing" option
+     */
+    inline void set_indexing(std::string_view value);
+    /**
+     * @param value Value of "cache" option
+     */
+    inline void set_caching_policy(std::string_view value);
+    /**
+     * @param value Value of "directory" option
+     */
+    inline void set_directory_storage(std::string_view value);
+    /**
+     * @param value Value of "journal" option
+     */
+    inline void set_metadata_journal(std::string_view value);
+    /**
+     * @param value Value of "wal" option
+     */
+    inline void set_write_ahead_log(std::string_view value);
+
+private:
+    static inline size_t parse_number(std::string_view option, std::string_view value);
+};
+
+inline mount_options::mount_options() {
+    set_indexing(configuration::default_indexing);
+    set_caching_policy(configuration::default_caching_policy);
+    set_directory_storage(configuration::default_directory_storage);
+    set_metadata_journal(configuration::default_metadata_journal);
+    set_write_ahead_log(configuration::default_write_ahead_log);
+}
+
+inline void mount_options::set_indexing(std::string_view value) {
+    if (value == "custom") {
+        indexing = indexing_type::custom;
+    } else if (value == "full_path") {
+        indexing = indexing_type::full_path;
+    } else if (value == "inline_attributes") {
+        indexing = indexing_type::inline_attributes;
+    } else if (value == "inode") {
+        indexing = indexing_type::inode;
+    } else {
+        throw exceptions::invalid_mount_option("indexing=" + std::string(value));
+    }
+}
+
+inline void mount_options::set_caching_policy(std::string_view value) {
+    size_t delimiter = value.find(':');
+    std::string_view name = value.substr(0, delimiter);
+    std::string_view argument = delimiter != std::string_view::npos ? value.substr(delimiter + 1) : std::string_view();
+    std::string option = "cache=" + std::string(value);
+
+    if (name == "ttl") {
+        caching_policy = caching_policy_type::hold_closed_cache_for;
+        if (!argument.empty()) {
+            cache_valid_duration = std::chrono::seconds(parse_number(option, argument));
+        }
+    } else if (name == "last_close" && argument.empty()) {
+        caching_policy = caching_policy_type::evict_on_last_close;
+    } else if (name == "memory") {
+        caching_policy = caching_policy_type::evict_over_memory_budget;
+        if (!argument.empty()) {
+            cache_memory_budget = parse_number(option, argument) * 1024 * 1024;
+        }
+    } else if (name == "arc") {
+        caching_policy = caching_policy_type::adaptive_replacement;
+        if (!argument.empty()) {
+            cache_capacity = parse_number(option, argument);
+        }
+    } else if (name == "tinylfu") {
+        caching_policy = caching_policy_type::window_tiny_lfu;
+        if (!argument.empty()) {
+            cache_capacity = parse_number(option, argument);
+        }
+    } else {
+        throw exceptions::invalid_mount_option(option);
+    }
+}
+
+inline void mount_options::set_directory_storage(std::string_view value) {
+    if (value == "object") {
+        directory_storage = directory_storage_type::object;
+    } else if (value == "omap") {
+        directory_storage = directory_storage_type::ordered_map;
+    } else {
+        throw exceptions::invalid_mount_option("directory=" + std::string(value));
+    }
+}
+
+inline void mount_options::set_metadata_journal(std::string_view value) {
+    if (value == "on") {
+        metadata_journal = true;
+    } else if (value == "off") {
+        metadata_journal = false;
+    } else {
+        throw exceptions::invalid_mount_option("journal=" + std::string(value));
+    }
+}
+
+inline void mount_options::set_write_ahead_log(std::string_view value) {
+    if (value == "off") {
+        write_ahead_log_directory.clear();
+    } else if (!value.empty()) {
+        write_ahead_log_directory = value;
+    } else {
+        throw exceptions::invalid_mount_option("wal=");
+    }
+}
+
+inline size_t mount_options::parse_number(std::string_view option, std::string_view value) {
+    size_t result;
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+    if (error != std::errc() || end != value.data() + value.size()) {
+        throw exceptions::invalid_mount_option(option);
+    }
+    return result;
+}
+
+}
+
+#endif //NMFS__MOUNT_OPTIONS_HPP
@@ -2,52 +2,289 @@
 #define NMFS_STRUCTURES_DIRECTORY_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <set>
 #include <shared_mutex>
 #include <string>
-#include <set>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 #include "../fuse.hpp"
 #include "../exceptions/is_not_directory.hpp"
 #include "../exceptions/file_does_not_exist.hpp"
-#include "../exceptions/type_not_supported.hpp"
 #include "../logger/log.hpp"
+#include "../memory_slices/owner_slice.hpp"
 #include "metadata.hpp"
+#include "fragment_image.hpp"
+#include "on_disk/directory.hpp"
+#include "utils/data_object_key.hpp"
 
 namespace nmfs::structures {
 
+/**
+ * Directory whose entries are split into hash-range fragments
+ *
+ * Each fragment is a separate backend object, listed in a header object. Nothing is read when a directory is
+ * constructed; the header is loaded by the first operation on entries, and fragments when an entry in their range
+ * is looked up, flushed only when they are changed, and split in two when they grow over
+ * configuration::directory_fragment_size.
+ *
+ * A loaded fragment object is kept as fragment_image and read in place, and only changed entries are held
+ * decoded. Changes are appended to the object on flush, until the object is encoded again as they grow.
+ *
+ * With ordered map storage, each entry and each fragment record of the header is a value in the ordered map of
+ * its object, keyed by file name and fragment id. Only changed values are written on flush.
+ *
+ * Entries are added, removed and looked up under a shared lock of the directory, and a lock of the fragment they
+ * belong to, so operations on different fragments run in parallel. Fragments are split under an exclusive lock of
+ * the structure. move_entry requires exclusive locks of both directories as well.
+ */
 template<typename indexing>
 class directory {
 public:
     using directory_entry_type = typename indexing::directory_entry_type;
 
+    /**
+     * An entry listed by read_entries, and the cursor readdir continues from after it
+     */
+    struct listed_entry {
+        directory_entry_type entry;
+        off_t cursor;
+    };
+
+    /**
+     * Cursors below this are left for "." and ".."
+     */
+    static constexpr off_t first_entry_cursor = 3;
+
     metadata<indexing>& directory_metadata;
 
     explicit inline directory(metadata<indexing>& metadata);
-    inline directory(directory&& other, metadata<indexing>& metadata, std::string_view old_directory_path, std::string_view new_directory_path);
+    /**
+     * Move entries of a renamed directory to the key of new metadata, after entries under it are moved
+     */
+    inline directory(directory&& other, metadata<indexing>& metadata);
     directory(const directory&) = delete;
-    directory(directory&&) noexcept = default;
+    inline directory(directory&& other) noexcept;
     inline ~directory();
 
     inline void add_file(std::string_view file_name, const metadata<indexing>& metadata);
     inline void remove_file(std::string_view file_name);
     inline void flush() const;
-    inline void fill_buffer(const fuse_directory_filler& filler);
-    [[nodiscard]] constexpr size_t number_of_files() const;
-    [[nodiscard]] constexpr bool empty() const;
+    [[nodiscard]] inline bool is_dirty() const;
+    /**
+     * Entries in readdir order following the given cursor
+     *
+     * Entries are ordered by bit-reversed name_hash, so each fragment covers a contiguous range of cursors and only
+     * fragments in the range of the returned entries are loaded. Names sharing name_hash are ordered by name_tie_break,
+     * so a cursor stays valid while other entries change. Only two names sharing both hashes share a cursor, and the
+     * second of them is skipped if a listing stops between them.
+     * @param cursor Value below first_entry_cursor to start from the first entry, or a cursor of a listed entry
+     * @param count Maximum number of entries
+     */
+    [[nodiscard]] inline std::vector<listed_entry> read_entries(off_t cursor, size_t count) const;
+    /**
+     * Fill listed entries with their cursors until the buffer is full
+     * @param stats Attributes in the order of entries, or empty to fill only file types
+     * @return false if the buffer became full
+     */
+    inline bool fill_buffer(const fuse_directory_filler& filler, const std::vector<listed_entry>& entries, const std::vector<std::optional<struct stat>>& stats = {}) const;
+    template<typename function_type>
+    inline void for_each_entry(function_type function) const;
+    [[nodiscard]] inline size_t number_of_files() const;
+    [[nodiscard]] inline bool empty() const;
+    /**
+     * Approximate number of bytes this directory occupies in memory, excluding its metadata
+     */
+    [[nodiscard]] inline size_t memory_usage() const;
+    /**
+     * Whether memory usage may have changed since the last call, as fragments were loaded or entries changed
+     */
+    [[nodiscard]] inline bool take_resized() const;
     inline void remove();
-    inline const directory_entry_type& get_entry(std::string_view file_name) const;
+    /**
+     * Entries may be decoded from a fragment image on lookup, so they are returned by value
+     */
+    [[nodiscard]] inline directory_entry_type get_entry(std::string_view file_name) const;
+    /**
+     * Replace the entry with the same file name
+     * @return false if there is no such entry
+     */
+    inline bool update_entry(directory_entry_type entry);
     inline void move_entry(std::string_view old_path, std::string_view new_path, directory& target_directory);
+    /**
+     * Load every fragment, before all entries are visited or objects of this directory are removed
+     */
+    inline void load_fragments() const;
 
 protected:
-    std::set<directory_entry_type> files;
-    size_t size;
+    /**
+     * Hash and equality of entries by file name, so entries are looked up by std::string_view in O(1)
+     */
+    struct entry_hash {
+        using is_transparent = void;
+
+        inline size_t operator()(std::string_view file_name) const;
+        inline size_t operator()(const directory_entry_type& entry) const;
+    };
+
+    struct entry_equal {
+        using is_transparent = void;
+
+        template<typename left_type, typename right_type>
+        inline bool operator()(const left_type& left, const right_type& right) const;
+    };
+
+    /**
+     * Entries of a hash range, where a fragment of depth d holds file names whose lowest d bits of name_hash equal
+     * its value. Its id is (1 << d) | value, which is also the index of its backend object.
+     */
+    struct fragment {
+        /**
+         * Entries as of when the object was last encoded
+         */
+        fragment_image<indexing> image;
+        /**
+         * Image written by flush, which replaces image on next change as readers may be using image while flushing
+         */
+        std::optional<fragment_image<indexing>> encoded_image;
+        /**
+         * Entries added or changed since image was encoded, which override entries of image
+         */
+        std::unordered_set<directory_entry_type, entry_hash, entry_equal> files;
+        /**
+         * File names whose entries in image are removed or overridden
+         */
+        std::unordered_set<std::string, entry_hash, entry_equal> masked_names;
+        on_disk_size_type number_of_files = 0;
+        /**
+         * Number of bytes written to the object, where changes are appended
+         */
+        size_t object_size = 0;
+        /**
+         * Size of the fragment if it was encoded now
+         */
+        size_t size = sizeof(on_disk::fragment_image);
+        bool loaded = false;
+        /**
+         * Whole fragment needs to be written
+         */
+        bool dirty = false;
+        /**
+         * Record of this fragment in the header is changed
+         */
+        bool record_dirty = false;
+        /**
+         * Entries changed since last flush
+         */
+        std::set<std::string> updated_names;
+        std::set<std::string> removed_names;
+        /**
+         * Held while entries of this fragment are read or changed
+         */
+        std::unique_ptr<std::mutex> mutex = std::make_unique<std::mutex>();
+    };
+
+    static constexpr uint32_t header_id = 0;
+    static constexpr uint32_t root_fragment_id = 1;
+    static constexpr uint32_t maximum_fragment_depth = 24;
+
+    mutable std::map<uint32_t, fragment> fragments;
+    /**
+     * Fragments split since last flush, whose objects are removed after the header is written
+     */
+    mutable std::vector<uint32_t> removed_fragments;
+    mutable std::atomic<size_t> number_of_entries;
     mutable std::shared_ptr<std::shared_mutex> mutex;
-    mutable bool dirty;
+    /**
+     * Held shared while fragments are looked up, and exclusively while they are split
+     */
+    mutable std::shared_ptr<std::shared_mutex> structure_mutex;
+    /**
+     * Header may be loaded by any operation holding structure_mutex shared
+     */
+    mutable std::shared_ptr<std::mutex> load_mutex;
+    /**
+     * Held while fragments are written, so a flush finding this directory clean returns after the flush which cleaned it
+     */
+    mutable std::shared_ptr<std::mutex> flush_mutex;
+    mutable std::atomic<bool> header_loaded;
+    mutable std::atomic<bool> dirty;
+    mutable std::atomic<bool> header_dirty;
+    mutable std::atomic<bool> resized;
+    const bool ordered_map_storage;
+
+    /**
+     * Set dirty flag, and register this directory to the dirty set of cache_store if it was clean
+     * @param bytes Size of records changed since last flush, charged to the dirty set
+     */
+    inline void mark_dirty(size_t bytes = 0);
 
 private:
-    [[nodiscard]] inline std::unique_ptr<byte[]> serialize() const;
-    inline void parse(std::unique_ptr<byte[]> buffer);
+    [[nodiscard]] inline uint32_t locate(std::string_view file_name) const;
+    [[nodiscard]] inline uint32_t locate(uint32_t hash) const;
+    [[nodiscard]] inline std::unique_lock<std::mutex> lock_fragment(uint32_t id) const;
+    /**
+     * Load a fragment whose lock is held
+     */
+    inline fragment& load(uint32_t id) const;
+    /**
+     * Load a fragment whose lock is held to change it, replacing its image with the one written by last flush
+     */
+    inline fragment& load_for_update(uint32_t id);
+    /**
+     * Split the fragment of a file name if it is still over configuration::directory_fragment_size, taking an
+     * exclusive lock of the structure
+     */
+    inline void split_if_full(std::string_view file_name);
+    inline void split(uint32_t id);
+    [[nodiscard]] static inline std::optional<directory_entry_type> find_entry(const fragment& fragment, std::string_view file_name);
+    template<typename function_type>
+    static inline void for_each_name_in(const fragment& fragment, function_type function);
+    template<typename function_type>
+    static inline void for_each_entry_in(const fragment& fragment, function_type function);
+    /**
+     * Add or replace an entry, which is kept decoded until the fragment is encoded again
+     */
+    static inline void put_entry(fragment& fragment, directory_entry_type entry);
+    static inline void erase_entry(fragment& fragment, std::string_view file_name);
+    /**
+     * Record change of an entry in its fragment, and mark this directory dirty
+     */
+    inline void entry_updated(fragment& fragment, std::string_view file_name);
+    inline void entry_removed(fragment& fragment, std::string_view file_name);
+    inline void flush_fragment(uint32_t id, fragment& fragment) const;
+    inline void flush_header() const;
+    inline void load_header() const;
+    inline void remove_objects() const;
+    [[nodiscard]] inline utils::data_object_key fragment_key(uint32_t id) const;
+    [[nodiscard]] inline size_t header_size() const;
+    [[nodiscard]] inline owner_slice serialize_header() const;
+    /**
+     * @throw nmfs::exceptions::unsupported_format if the header object is not in directory_header format
+     */
+    inline void parse_header(const owner_slice& header) const;
+    /**
+     * Encode every entry of a fragment into an image
+     */
+    [[nodiscard]] inline owner_slice encode(const fragment& fragment) const;
+    /**
+     * Encode changes of a fragment since last flush, to be appended to its object
+     */
+    [[nodiscard]] inline owner_slice encode_changes(const fragment& fragment) const;
+    /**
+     * Apply changes appended to the object of a fragment after its image
+     */
+    inline void replay_changes(fragment& fragment) const;
+    [[nodiscard]] inline std::map<std::string, owner_slice> list_map(uint32_t id) const;
+    [[nodiscard]] static inline on_disk::directory_fragment to_record(uint32_t id, const fragment& fragment);
+    [[nodiscard]] static inline std::string record_key(uint32_t id);
+    [[nodiscard]] static constexpr uint32_t reverse_bits(uint32_t value);
+    [[nodiscard]] static inline owner_slice serialize(const directory_entry_type& entry);
 };
 
 }
@@ -1,8 +1,15 @@
 #ifndef NMFS_STRUCTURES_DIRECTORY_IMPL_HPP
 #define NMFS_STRUCTURES_DIRECTORY_IMPL_HPP
 
+#include <bit>
+#include <cstdio>
+#include <type_traits>
 #include "directory.hpp"
 #include "../utils.hpp"
+#include "../configuration.hpp"
+#include "../exceptions/unsupported_format.hpp"
+#include "utils/name_hash.hpp"
+#include "fragment_image.impl.hpp"
 
 #include "metadata.impl.hpp"
 
@@ -11,53 +18,90 @@ namespace nmfs::structures {
 template<typename indexing>
 inline directory<indexing>::directory(nmfs::structures::metadata<indexing>& metadata)
     : directory_metadata(metadata),
-      size(sizeof(on_disk_size_type)),
+      number_of_entries(0),
+      mutex(std::make_shared<std::shared_mutex>()),
+      structure_mutex(std::make_shared<std::shared_mutex>()),
+      load_mutex(std::make_shared<std::mutex>()),
+      flush_mutex(std::make_shared<std::mutex>()),
+      header_loaded(metadata.size == 0),
       dirty(metadata.size == 0),
-      mutex(std::make_shared<std::shared_mutex>()) {
+      header_dirty(metadata.size == 0),
+      resized(false),
+      ordered_map_storage(metadata.context.options.directory_storage == mount_options::directory_storage_type::ordered_map) {
     if (!S_ISDIR(metadata.mode)) {
         throw nmfs::exceptions::is_not_directory();
-    } else if (metadata.size > 0) {
-        std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(metadata.size);
-
-        metadata.read(buffer.get(), metadata.size, 0);
-        parse(std::move(buffer));
+    } else if (metadata.size == 0) {
+        fragments.emplace(root_fragment_id, fragment {
+            .loaded = true,
+            .dirty = true,
+            .record_dirty = true,
+        });
     }
 }
 
 template<typename indexing>
-directory<indexing>::directory(directory&& other, metadata<indexing>& metadata, std::string_view old_directory_path, std::string_view new_directory_path)
+directory<indexing>::directory(directory&& other, metadata<indexing>& metadata)
     : directory_metadata(metadata),
-      /* Moving files and size is deferred until moving children is finished */
+      number_of_entries(0),
+      mutex(std::make_shared<std::shared_mutex>()),
+      structure_mutex(std::make_shared<std::shared_mutex>()),
+      load_mutex(std::make_shared<std::mutex>()),
+      flush_mutex(std::make_shared<std::mutex>()),
+      header_loaded(true),
       dirty(false),
-      mutex(std::make_shared<std::shared_mutex>()) {
-    auto other_shared_lock = std::shared_lock(*other.mutex);
-    auto this_unique_lock = std::unique_lock(*mutex);
+      header_dirty(false),
+      resized(false),
+      ordered_map_storage(other.ordered_map_storage) {
+    auto other_unique_lock = std::unique_lock(*other.mutex);
+    auto& backend = *directory_metadata.context.backend;
 
+    other.load_header();
     other.dirty = false;
     other.directory_metadata.valid = false;
 
-    for (const auto& file: other.files) {
-        std::string old_path = std::string(old_directory_path) + path_delimiter + file.file_name;
-        std::string new_path = std::string(new_directory_path) + path_delimiter + file.file_name;
-        log::information(log_locations::directory_operation) << "Moving child entry (old_path = " << old_path << ", new_path = " << new_path << ")\n";
-        mode_t type = directory_metadata.context.cache->get_type(old_path);
-
-        if (S_ISDIR(type)) {
-            directory_metadata.context.cache->move_directory(old_path, new_path);
-        } else if (S_ISREG(type)) {
-            directory_metadata.context.cache->move(old_path, new_path);
-        } else {
-            throw nmfs::exceptions::type_not_supported(type);
-        }
+    // Fragments are written again under the key of new metadata
+    fragments = std::move(other.fragments);
+    other.fragments.clear();
+    for (auto& [id, fragment]: fragments) {
+        fragment.dirty = true;
+        fragment.record_dirty = true;
     }
+    number_of_entries = other.number_of_entries.load();
+    other.number_of_entries = 0;
+    dirty = true;
+    header_dirty = true;
 
-    other_shared_lock.unlock();
-    auto other_unique_lock = std::unique_lock(*other.mutex);
+    // Objects of the old key are removed after new ones are written, so a rename interrupted by a crash finds the
+    // directory under either key
+    flush();
+    backend.remove(other.directory_metadata.key);
+    for (const auto& [id, fragment]: fragments) {
+        backend.remove(other.fragment_key(id));
+    }
+    for (uint32_t id: other.removed_fragments) {
+        backend.remove(other.fragment_key(id));
+    }
+    other.removed_fragments.clear();
+    backend.remove(other.fragment_key(header_id));
+}
 
-    files = std::move(other.files);
-    size = other.size;
-    other.size = 0;
-    dirty = other.dirty;
+template<typename indexing>
+directory<indexing>::directory(directory&& other) noexcept
+    : directory_metadata(other.directory_metadata),
+      fragments(std::move(other.fragments)),
+      removed_fragments(std::move(other.removed_fragments)),
+      number_of_entries(other.number_of_entries.load()),
+      mutex(std::move(other.mutex)),
+      structure_mutex(std::move(other.structure_mutex)),
+      load_mutex(std::move(other.load_mutex)),
+      flush_mutex(other.flush_mutex),
+      header_loaded(other.header_loaded.load()),
+      dirty(other.dirty.load()),
+      header_dirty(other.header_dirty.load()),
+      resized(other.resized.load()),
+      ordered_map_storage(other.ordered_map_storage) {
+    other.dirty = false;
+    other.header_dirty = false;
 }
 
 template<typename indexing>
@@ -69,14 +113,27 @@ template<typename indexing>
 inline void directory<indexing>::add_file(std::string_view file_name, const metadata<indexing>& metadata) {
     log::information(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << "(file_name = " << file_name << ")\n";
 
-    auto content = directory_entry_type(std::string(file_name), metadata);
+    auto structure_lock = std::shared_lock(*structure_mutex);
+    uint32_t id = locate(file_name);
+    auto fragment_lock = lock_fragment(id);
+    auto& fragment = load_for_update(id);
 
-    auto result = files.emplace(std::move(content));
-    if (result.second) {
-        size += result.first->size();
-        dirty = true;
+    if (!find_entry(fragment, file_name).has_value()) {
+        auto content = directory_entry_type(std::string(file_name), metadata);
+
+        fragment.size += fragment_image<indexing>::record_size(content.size());
+        fragment.number_of_files++;
+        number_of_entries++;
+        put_entry(fragment, std::move(content));
+        entry_updated(fragment, file_name);
+
+        if (fragment.size > configuration::directory_fragment_size) {
+            fragment_lock.unlock();
+            structure_lock.unlock();
+            split_if_full(file_name);
+        }
     } else {
-        log::warning(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << " failed: files.emplace returned false";
+        log::warning(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << " failed: entry already exists";
     }
 }
 
@@ -84,14 +141,20 @@ template<typename indexing>
 inline void directory<indexing>::remove_file(std::string_view file_name) {
     log::information(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << "(file_name = " << file_name << ")\n";
 
-    auto iterator = std::find_if(files.begin(), files.end(), directory_entry_type::find_by_name(file_name));
-
-    if (iterator != files.end()) {
-        files.erase(iterator);
-        size -= iterator->size();
-        dirty = true;
+    auto structure_lock = std::shared_lock(*structure_mutex);
+    uint32_t id = locate(file_name);
+    auto fragment_lock = lock_fragment(id);
+    auto& fragment = load_for_update(id);
+    auto entry = find_entry(fragment, file_name);
+
+    if (entry.has_value()) {
+        fragment.size -= fragment_image<indexing>::record_size(entry->size());
+        fragment.number_of_files--;
+        number_of_entries--;
+        erase_entry(fragment, file_name);
+        entry_removed(fragment, file_name);
     } else {
-        log::warning(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << " failed: find_if returned files.end()";
+        log::warning(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << " failed: entry doesn't exist";
     }
 }
 
@@ -99,65 +162,715 @@ template<typename indexing>
 inline void directory<indexing>::flush() const {
     log::information(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << "()\n";
 
-    if (dirty) {
-        if (size < directory_metadata.size) {
-            directory_metadata.truncate(size);
+    auto flush_lock = std::unique_lock(*flush_mutex);
+    // Cleared first, so entries changed while flushing mark this directory dirty again
+    if (dirty.exchange(false)) {
+        auto& backend = *directory_metadata.context.backend;
+        auto structure_lock = std::shared_lock(*structure_mutex);
+        size_t size = header_size();
+        bool header_cleared = false;
+
+        // Fragments stay dirty until written, and the header is marked dirty again, so a failed flush is retried by the
+        // next one
+        try {
+            for (auto& [id, fragment]: fragments) {
+                auto fragment_lock = std::unique_lock(*fragment.mutex);
+                flush_fragment(id, fragment);
+                size += fragment.size;
+            }
+            if (header_dirty.exchange(false)) {
+                header_cleared = true;
+                flush_header();
+            }
+            // Split fragments are not referenced by the header any more
+            while (!removed_fragments.empty()) {
+                backend.remove(fragment_key(removed_fragments.back()));
+                removed_fragments.pop_back();
+            }
+        } catch (...) {
+            if (header_cleared) {
+                header_dirty = true;
+            }
+            dirty = true;
+            throw;
+        }
+
+        if (directory_metadata.size != size) {
+            directory_metadata.size = size;
+            directory_metadata.mark_dirty();
         }
-        directory_metadata.write(serialize().get(), size, 0);
         directory_metadata.flush();
-        dirty = false;
     } else if (directory_metadata.dirty) {
         directory_metadata.flush();
     }
 }
 
 template<typename indexing>
-inline std::unique_ptr<byte[]> directory<indexing>::serialize() const {
-    on_disk_size_type number_of_files = files.size();
-    std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(size);
-    size_t index = 0;
+bool directory<indexing>::is_dirty() const {
+    return dirty;
+}
+
+template<typename indexing>
+inline void directory<indexing>::mark_dirty(size_t bytes) {
+    resized = true;
+    if (!dirty.exchange(true) || bytes > 0) {
+        directory_metadata.context.cache->mark_dirty(*this, bytes);
+    }
+}
+
+template<typename indexing>
+uint32_t directory<indexing>::locate(std::string_view file_name) const {
+    return locate(utils::name_hash(file_name));
+}
+
+template<typename indexing>
+uint32_t directory<indexing>::locate(uint32_t hash) const {
+    load_header();
+
+    for (uint32_t depth = 0; depth <= maximum_fragment_depth; depth++) {
+        uint32_t id = (1u << depth) | (hash & ((1u << depth) - 1));
+        if (fragments.contains(id)) {
+            return id;
+        }
+    }
+
+    throw std::logic_error("directory::locate : fragments don't cover hash " + std::to_string(hash));
+}
+
+template<typename indexing>
+std::unique_lock<std::mutex> directory<indexing>::lock_fragment(uint32_t id) const {
+    return std::unique_lock(*fragments.at(id).mutex);
+}
+
+template<typename indexing>
+typename directory<indexing>::fragment& directory<indexing>::load(uint32_t id) const {
+    auto& fragment = fragments.at(id);
+
+    if (!fragment.loaded) {
+        log::information(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << "(id = " << id << ")\n";
+
+        if (fragment.number_of_files > 0 && ordered_map_storage) {
+            fragment.files.reserve(fragment.number_of_files);
+            fragment.size = sizeof(on_disk::fragment_image);
+            for (const auto& [file_name, value]: list_map(id)) {
+                const byte* current = value.data();
+                auto content = directory_entry_type(&current);
+                fragment.size += fragment_image<indexing>::record_size(content.size());
+                fragment.files.emplace(std::move(content));
+            }
+            fragment.number_of_files = fragment.files.size();
+        } else if (fragment.number_of_files > 0) {
+            fragment.image = fragment_image<indexing>(directory_metadata.context.backend->get(fragment_key(id)));
+            fragment.object_size = fragment.image.object_size();
+            replay_changes(fragment);
+        }
+        fragment.loaded = true;
+        resized = true;
+    }
+    return fragment;
+}
+
+template<typename indexing>
+typename directory<indexing>::fragment& directory<indexing>::load_for_update(uint32_t id) {
+    auto& fragment = load(id);
+
+    if (fragment.encoded_image.has_value()) {
+        // Entries changed after the image was written stay decoded
+        fragment.image = std::move(*fragment.encoded_image);
+        fragment.encoded_image.reset();
+        resized = true;
+        std::erase_if(fragment.files, [&fragment](const directory_entry_type& entry) {
+            return !fragment.updated_names.contains(entry.file_name);
+        });
+        fragment.masked_names.clear();
+        fragment.masked_names.insert(fragment.updated_names.begin(), fragment.updated_names.end());
+        fragment.masked_names.insert(fragment.removed_names.begin(), fragment.removed_names.end());
+    }
+    return fragment;
+}
+
+template<typename indexing>
+void directory<indexing>::split_if_full(std::string_view file_name) {
+    auto structure_unique_lock = std::unique_lock(*structure_mutex);
+    // Another writer may have split the fragment meanwhile
+    uint32_t id = locate(file_name);
+
+    if (load(id).size > configuration::directory_fragment_size) {
+        split(id);
+    }
+}
+
+template<typename indexing>
+void directory<indexing>::split(uint32_t id) {
+    const uint32_t depth = std::bit_width(id) - 1;
+
+    if (depth >= maximum_fragment_depth) {
+        return;
+    }
+
+    const uint32_t value = id ^ (1u << depth);
+    const uint32_t low_id = (1u << (depth + 1)) | value;
+    const uint32_t high_id = low_id | (1u << depth);
+    auto parent = std::move(fragments.extract(id).mapped());
+    auto low = fragment { .loaded = true, .dirty = true, .record_dirty = true };
+    auto high = fragment { .loaded = true, .dirty = true, .record_dirty = true };
+
+    log::information(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << "(id = " << id << ", low_id = " << low_id << ", high_id = " << high_id << ")\n";
+
+    for_each_entry_in(parent, [depth, &low, &high](const directory_entry_type& entry) {
+        auto& child = (utils::name_hash(entry.file_name) >> depth) & 1 ? high : low;
+
+        child.size += fragment_image<indexing>::record_size(entry.size());
+        child.number_of_files++;
+        child.files.emplace(entry);
+    });
+
+    fragments.emplace(low_id, std::move(low));
+    fragments.emplace(high_id, std::move(high));
+    removed_fragments.push_back(id);
+    header_dirty = true;
+}
+
+template<typename indexing>
+std::optional<typename directory<indexing>::directory_entry_type> directory<indexing>::find_entry(const fragment& fragment, std::string_view file_name) {
+    if (auto iterator = fragment.files.find(file_name); iterator != fragment.files.end()) {
+        return *iterator;
+    } else if (fragment.masked_names.contains(file_name)) {
+        return std::nullopt;
+    } else {
+        return fragment.image.find(file_name);
+    }
+}
+
+template<typename indexing>
+template<typename function_type>
+void directory<indexing>::for_each_name_in(const fragment& fragment, function_type function) {
+    fragment.image.for_each([&fragment, &function](const typename fragment_image<indexing>::record& record) {
+        if (!fragment.masked_names.contains(record.name)) {
+            function(record.name);
+        }
+    });
+    for (const auto& content: fragment.files) {
+        function(std::string_view(content.file_name));
+    }
+}
+
+template<typename indexing>
+template<typename function_type>
+void directory<indexing>::for_each_entry_in(const fragment& fragment, function_type function) {
+    fragment.image.for_each([&fragment, &function](const typename fragment_image<indexing>::record& record) {
+        if (!fragment.masked_names.contains(record.name)) {
+            function(fragment_image<indexing>::decode(record));
+        }
+    });
+    for (const auto& content: fragment.files) {
+        function(content);
+    }
+}
+
+template<typename indexing>
+void directory<indexing>::put_entry(fragment& fragment, directory_entry_type entry) {
+    if (auto iterator = fragment.files.find(entry); iterator != fragment.files.end()) {
+        fragment.files.erase(iterator);
+    }
+    fragment.masked_names.emplace(entry.file_name);
+    fragment.files.emplace(std::move(entry));
+}
+
+template<typename indexing>
+void directory<indexing>::erase_entry(fragment& fragment, std::string_view file_name) {
+    if (auto iterator = fragment.files.find(file_name); iterator != fragment.files.end()) {
+        fragment.files.erase(iterator);
+    }
+    fragment.masked_names.emplace(file_name);
+}
+
+template<typename indexing>
+void directory<indexing>::entry_updated(fragment& fragment, std::string_view file_name) {
+    auto name = std::string(file_name);
+
+    fragment.removed_names.erase(name);
+    bool changed = fragment.updated_names.emplace(std::move(name)).second;
+    fragment.record_dirty = true;
+    header_dirty = true;
+    // Each changed entry is written once by next flush, however many times it changes
+    mark_dirty(changed ? sizeof(on_disk::fragment_record) + file_name.size() : 0);
+}
+
+template<typename indexing>
+void directory<indexing>::entry_removed(fragment& fragment, std::string_view file_name) {
+    auto name = std::string(file_name);
+
+    fragment.updated_names.erase(name);
+    bool changed = fragment.removed_names.emplace(std::move(name)).second;
+    fragment.record_dirty = true;
+    header_dirty = true;
+    mark_dirty(changed ? sizeof(on_disk::fragment_record) + file_name.size() : 0);
+}
+
+template<typename indexing>
+void directory<indexing>::flush_fragment(uint32_t id, fragment& fragment) const {
+    auto& backend = *directory_metadata.context.backend;
+    bool changed = !fragment.updated_names.empty() || !fragment.removed_names.empty();
+
+    if (!ordered_map_storage && (fragment.dirty || changed)) {
+        owner_slice changes = fragment.dirty ? owner_slice(0) : encode_changes(fragment);
+
+        // Object is encoded again once appended changes would make it twice as large as encoded entries
+        if (fragment.dirty || fragment.object_size == 0 || fragment.object_size + changes.size() > 2 * fragment.size) {
+            owner_slice object = encode(fragment);
+            backend.put(fragment_key(id), object);
+            fragment.object_size = object.size();
+            fragment.encoded_image.emplace(std::move(object));
+            resized = true;
+        } else {
+            backend.put(fragment_key(id), fragment.object_size, changes);
+            fragment.object_size += changes.size();
+        }
+    } else if (fragment.dirty) {
+        std::map<std::string, owner_slice> values;
+
+        for_each_entry_in(fragment, [&values](const directory_entry_type& content) {
+            values.emplace(content.file_name, serialize(content));
+        });
+        backend.update_map(fragment_key(id), values, {});
+    } else if (changed) {
+        std::map<std::string, owner_slice> values;
+
+        for (const auto& file_name: fragment.updated_names) {
+            values.emplace(file_name, serialize(*fragment.files.find(std::string_view(file_name))));
+        }
+        backend.update_map(fragment_key(id), values, fragment.removed_names);
+    }
+
+    fragment.dirty = false;
+    fragment.updated_names.clear();
+    fragment.removed_names.clear();
+}
+
+template<typename indexing>
+void directory<indexing>::flush_header() const {
+    auto& backend = *directory_metadata.context.backend;
+
+    if (ordered_map_storage) {
+        std::map<std::string, owner_slice> records;
+        std::set<std::string> removed_records;
+
+        for (auto& [id, fragment]: fragments) {
+            auto fragment_lock = std::unique_lock(*fragment.mutex);
+            if (fragment.record_dirty) {
+                auto record = owner_slice(sizeof(on_disk::directory_fragment));
+                *reinterpret_cast<on_disk::directory_fragment*>(record.data()) = to_record(id, fragment);
+                records.emplace(record_key(id), std::move(record));
+                fragment.record_dirty = false;
+            }
+        }
+        for (uint32_t id: removed_fragments) {
+            removed_records.emplace(record_key(id));
+        }
+        backend.update_map(fragment_key(header_id), records, removed_records);
+    } else {
+        backend.put(fragment_key(header_id), serialize_header());
+        for (auto& [id, fragment]: fragments) {
+            auto fragment_lock = std::unique_lock(*fragment.mutex);
+            fragment.record_dirty = false;
+        }
+    }
+}
+
+template<typename indexing>
+void directory<indexing>::load_header() const {
+    // Checked without the lock first, so lookups of a loaded directory don't serialize on it
+    if (header_loaded.load(std::memory_order_acquire)) {
+        return;
+    }
+    auto lock = std::unique_lock(*load_mutex);
+
+    if (header_loaded.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    log::information(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << "()\n";
+    if (ordered_map_storage) {
+        for (const auto& [key, value]: list_map(header_id)) {
+            if (value.size() != sizeof(on_disk::directory_fragment)) {
+                throw nmfs::exceptions::unsupported_format("directory fragment record", 0);
+            }
+            auto record = reinterpret_cast<const on_disk::directory_fragment*>(value.data());
+            fragments.emplace(record->id, fragment {
+                .number_of_files = record->number_of_files,
+                .size = record->size,
+            });
+            number_of_entries += record->number_of_files;
+        }
+    } else {
+        owner_slice header = directory_metadata.context.backend->get(fragment_key(header_id));
+        parse_header(header);
+    }
+    resized = true;
+    header_loaded.store(true, std::memory_order_release);
+}
+
+template<typename indexing>
+std::map<std::string, owner_slice> directory<indexing>::list_map(uint32_t id) const {
+    std::map<std::string, owner_slice> values;
+    auto key = fragment_key(id);
+    bool more = true;
+
+    while (more) {
+        size_t previous_size = values.size();
+        std::string after = values.empty() ? std::string() : values.rbegin()->first;
+
+        more = directory_metadata.context.backend->list_map(key, after, configuration::directory_listing_size, values);
+        if (values.size() == previous_size) {
+            break;
+        }
+    }
+    return values;
+}
+
+template<typename indexing>
+void directory<indexing>::remove_objects() const {
+    load_header();
+    auto& backend = *directory_metadata.context.backend;
+
+    for (const auto& [id, fragment]: fragments) {
+        backend.remove(fragment_key(id));
+    }
+    for (uint32_t id: removed_fragments) {
+        backend.remove(fragment_key(id));
+    }
+    backend.remove(fragment_key(header_id));
+}
+
+template<typename indexing>
+utils::data_object_key directory<indexing>::fragment_key(uint32_t id) const {
+    return utils::data_object_key(directory_metadata.key, id);
+}
+
+template<typename indexing>
+size_t directory<indexing>::header_size() const {
+    return sizeof(on_disk::directory_header) + fragments.size() * sizeof(on_disk::directory_fragment);
+}
+
+template<typename indexing>
+owner_slice directory<indexing>::serialize_header() const {
+    auto buffer = owner_slice(header_size());
+    byte* current = buffer.data();
+
+    *reinterpret_cast<on_disk::directory_header*>(current) = on_disk::directory_header {
+        .magic = on_disk::directory_header::current_magic,
+        .version = on_disk::directory_header::current_version,
+        .number_of_fragments = static_cast<on_disk_size_type>(fragments.size()),
+    };
+    current += sizeof(on_disk::directory_header);
+
+    for (const auto& [id, fragment]: fragments) {
+        auto fragment_lock = std::unique_lock(*fragment.mutex);
+        *reinterpret_cast<on_disk::directory_fragment*>(current) = to_record(id, fragment);
+        current += sizeof(on_disk::directory_fragment);
+    }
+
+    return buffer;
+}
+
+template<typename indexing>
+void directory<indexing>::parse_header(const owner_slice& header) const {
+    // Directories of earlier versions kept their entries in this object, which has no magic
+    if (header.size() < sizeof(on_disk::directory_header)) {
+        throw nmfs::exceptions::unsupported_format("directory header", 0);
+    }
+    auto on_disk_header = reinterpret_cast<const on_disk::directory_header*>(header.data());
+    if (on_disk_header->magic != on_disk::directory_header::current_magic || on_disk_header->version != on_disk::directory_header::current_version) {
+        throw nmfs::exceptions::unsupported_format("directory header", on_disk_header->magic == on_disk::directory_header::current_magic ? on_disk_header->version : 0);
+    }
+
+    on_disk_size_type number_of_fragments = on_disk_header->number_of_fragments;
+    if ((header.size() - sizeof(on_disk::directory_header)) / sizeof(on_disk::directory_fragment) < number_of_fragments) {
+        throw nmfs::exceptions::unsupported_format("directory header", on_disk_header->version);
+    }
+    auto on_disk_fragments = reinterpret_cast<const on_disk::directory_fragment*>(header.data() + sizeof(on_disk::directory_header));
+
+    for (on_disk_size_type i = 0; i < number_of_fragments; i++) {
+        fragments.emplace(on_disk_fragments[i].id, fragment {
+            .number_of_files = on_disk_fragments[i].number_of_files,
+            .size = on_disk_fragments[i].size,
+        });
+        number_of_entries += on_disk_fragments[i].number_of_files;
+    }
+}
+
+template<typename indexing>
+on_disk::directory_fragment directory<indexing>::to_record(uint32_t id, const fragment& fragment) {
+    return on_disk::directory_fragment {
+        .id = id,
+        .number_of_files = fragment.number_of_files,
+        .size = static_cast<on_disk_size_type>(fragment.size),
+    };
+}
+
+template<typename indexing>
+std::string directory<indexing>::record_key(uint32_t id) {
+    // Fixed width keeps order of map keys the same as order of ids
+    char buffer[9];
+    std::snprintf(buffer, sizeof(buffer), "%08x", id);
+    return std::string(buffer);
+}
 
-    *reinterpret_cast<on_disk_size_type*>(&buffer[index]) = number_of_files;
-    index += sizeof(number_of_files);
+template<typename indexing>
+constexpr uint32_t directory<indexing>::reverse_bits(uint32_t value) {
+    uint32_t result = 0;
 
-    for (const auto& file: files) {
-        index += file.serialize(&buffer[index]);
+    for (int i = 0; i < 32; i++) {
+        result = result << 1 | (value & 1);
+        value >>= 1;
     }
+    return result;
+}
 
+template<typename indexing>
+owner_slice directory<indexing>::serialize(const directory_entry_type& entry) {
+    auto buffer = owner_slice(entry.size());
+    entry.serialize(buffer.data());
     return buffer;
 }
 
 template<typename indexing>
-inline void directory<indexing>::parse(std::unique_ptr<byte[]> buffer) {
-    const byte* current = buffer.get();
+owner_slice directory<indexing>::encode(const fragment& fragment) const {
+    std::vector<std::pair<std::string, std::string_view>> named_values;
+    std::vector<owner_slice> serialized_entries;
+    std::vector<typename fragment_image<indexing>::record> records;
+
+    named_values.reserve(fragment.number_of_files);
+    serialized_entries.reserve(fragment.files.size());
+
+    // Values of the image are copied as they are, and only changed entries are serialized
+    fragment.image.for_each([&fragment, &named_values](const typename fragment_image<indexing>::record& record) {
+        if (!fragment.masked_names.contains(record.name)) {
+            named_values.emplace_back(record.name, record.value);
+        }
+    });
+    for (const auto& content: fragment.files) {
+        const auto& serialized = serialized_entries.emplace_back(serialize(content));
+        named_values.emplace_back(content.file_name, fragment_image<indexing>::split(serialized.to_string_view()).value);
+    }
+
+    std::sort(named_values.begin(), named_values.end());
+    records.reserve(named_values.size());
+    for (const auto& [file_name, value]: named_values) {
+        records.push_back({ .name = file_name, .value = value });
+    }
+
+    return fragment_image<indexing>::encode(records);
+}
+
+template<typename indexing>
+owner_slice directory<indexing>::encode_changes(const fragment& fragment) const {
+    size_t size = 0;
+
+    for (const auto& file_name: fragment.updated_names) {
+        size += sizeof(on_disk::fragment_change) + fragment.files.find(std::string_view(file_name))->size();
+    }
+    for (const auto& file_name: fragment.removed_names) {
+        size += sizeof(on_disk::fragment_change) + sizeof(on_disk_size_type) + file_name.size();
+    }
 
-    on_disk_size_type number_of_files = *reinterpret_cast<const on_disk_size_type*>(current);
-    current += sizeof(on_disk_size_type);
+    auto buffer = owner_slice(size);
+    byte* current = buffer.data();
 
-    for (on_disk_size_type i = 0; i < number_of_files; i++) {
-        auto content = directory_entry_type(&current);
-        files.emplace(std::move(content));
+    for (const auto& file_name: fragment.updated_names) {
+        *reinterpret_cast<on_disk::fragment_change*>(current) = on_disk::fragment_change::update;
+        current += sizeof(on_disk::fragment_change);
+        current += fragment.files.find(std::string_view(file_name))->serialize(current);
+    }
+    for (const auto& file_name: fragment.removed_names) {
+        *reinterpret_cast<on_disk::fragment_change*>(current) = on_disk::fragment_change::remove;
+        current += sizeof(on_disk::fragment_change);
+        *reinterpret_cast<on_disk_size_type*>(current) = file_name.size();
+        current += sizeof(on_disk_size_type);
+        current = std::copy(file_name.begin(), file_name.end(), current);
     }
 
-    size = current - buffer.get();
+    return buffer;
 }
 
 template<typename indexing>
-void directory<indexing>::fill_buffer(const fuse_directory_filler& filler) {
-    for (const auto& content: files) {
-        content.fill(filler);
+void directory<indexing>::replay_changes(fragment& fragment) const {
+    std::string_view changes = fragment.image.changes();
+    const byte* current = changes.data();
+    const byte* end = changes.data() + changes.size();
+
+    while (current < end) {
+        auto change = *reinterpret_cast<const on_disk::fragment_change*>(current);
+        current += sizeof(on_disk::fragment_change);
+
+        if (change == on_disk::fragment_change::update) {
+            put_entry(fragment, directory_entry_type(&current));
+        } else if (change == on_disk::fragment_change::remove) {
+            on_disk_size_type file_name_length = *reinterpret_cast<const on_disk_size_type*>(current);
+            current += sizeof(on_disk_size_type);
+            erase_entry(fragment, std::string_view(current, file_name_length));
+            current += file_name_length;
+        } else {
+            throw nmfs::exceptions::unsupported_format("directory fragment change", static_cast<uint32_t>(change));
+        }
+    }
+
+    fragment.number_of_files = 0;
+    fragment.size = sizeof(on_disk::fragment_image);
+    fragment.image.for_each([&fragment](const typename fragment_image<indexing>::record& record) {
+        if (!fragment.masked_names.contains(record.name)) {
+            fragment.number_of_files++;
+            fragment.size += fragment_image<indexing>::record_size(sizeof(on_disk_size_type) + record.name.size() + record.value.size());
+        }
+    });
+    for (const auto& content: fragment.files) {
+        fragment.number_of_files++;
+        fragment.size += fragment_image<indexing>::record_size(content.size());
     }
 }
 
 template<typename indexing>
-constexpr size_t directory<indexing>::number_of_files() const {
+std::vector<typename directory<indexing>::listed_entry> directory<indexing>::read_entries(off_t cursor, size_t count) const {
+    // A cursor is first_entry_cursor + (reversed hash << 16 | tie-break hash), so it doesn't depend on other entries
+    constexpr uint32_t tie_break_bits = 16;
+    const bool from_first = cursor < first_entry_cursor;
+    const uint64_t last_position = from_first ? 0 : static_cast<uint64_t>(cursor - first_entry_cursor);
+    std::vector<listed_entry> result;
+    uint64_t range_begin = last_position >> tie_break_bits;
+    auto structure_lock = std::shared_lock(*structure_mutex);
+
+    while (result.size() < count && range_begin <= UINT32_MAX) {
+        uint32_t id = locate(reverse_bits(static_cast<uint32_t>(range_begin)));
+        auto fragment_lock = lock_fragment(id);
+        const auto& fragment = load(id);
+        const uint32_t depth = std::bit_width(id) - 1;
+        // Fragment of depth d covers reversed hashes sharing their highest d bits
+        const uint64_t range_end = ((range_begin >> (32 - depth)) + 1) << (32 - depth);
+        std::vector<std::pair<uint64_t, std::string>> candidates;
+
+        // Only names are read to order entries, and only listed entries are decoded
+        for_each_name_in(fragment, [range_begin, &candidates](std::string_view file_name) {
+            uint32_t reversed_hash = reverse_bits(utils::name_hash(file_name));
+            if (reversed_hash >= range_begin) {
+                uint64_t position = static_cast<uint64_t>(reversed_hash) << tie_break_bits | utils::name_tie_break(file_name);
+                candidates.emplace_back(position, std::string(file_name));
+            }
+        });
+        std::sort(candidates.begin(), candidates.end());
+
+        for (size_t i = 0; i < candidates.size() && result.size() < count; i++) {
+            const auto& [position, file_name] = candidates[i];
+
+            if (from_first || position > last_position) {
+                result.push_back(listed_entry {
+                    .entry = *find_entry(fragment, file_name),
+                    .cursor = static_cast<off_t>(position) + first_entry_cursor,
+                });
+            }
+        }
+
+        range_begin = range_end;
+    }
+
+    return result;
+}
+
+template<typename indexing>
+bool directory<indexing>::fill_buffer(const fuse_directory_filler& filler, const std::vector<listed_entry>& entries, const std::vector<std::optional<struct stat>>& stats) const {
+    for (size_t i = 0; i < entries.size(); i++) {
+        const auto& [entry, cursor] = entries[i];
+        int full;
+
+        if (i < stats.size() && stats[i].has_value()) {
+            full = filler(entry.file_name.c_str(), *stats[i], cursor);
+        } else {
+            full = entry.fill(filler, cursor);
+        }
+        if (full) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename indexing>
+template<typename function_type>
+void directory<indexing>::for_each_entry(function_type function) const {
+    std::vector<directory_entry_type> entries;
+
+    load_header();
+    {
+        // Entries are copied, so function may open this directory again
+        auto structure_lock = std::shared_lock(*structure_mutex);
+
+        entries.reserve(number_of_entries);
+        for (const auto& [id, fragment]: fragments) {
+            auto fragment_lock = std::unique_lock(*fragment.mutex);
+            for_each_entry_in(load(id), [&entries](const directory_entry_type& content) {
+                entries.push_back(content);
+            });
+        }
+    }
+
+    for (const auto& content: entries) {
+        function(content);
+    }
+}
+
+template<typename indexing>
+void directory<indexing>::load_fragments() const {
+    load_header();
+    auto structure_lock = std::shared_lock(*structure_mutex);
+
+    for (const auto& [id, fragment]: fragments) {
+        auto fragment_lock = std::unique_lock(*fragment.mutex);
+        load(id);
+    }
+}
+
+template<typename indexing>
+size_t directory<indexing>::number_of_files() const {
     auto lock = std::shared_lock(*mutex);
-    return files.size();
+    load_header();
+    return number_of_entries;
 }
 
 template<typename indexing>
-constexpr bool directory<indexing>::empty() const {
-    return files.empty();
+bool directory<indexing>::empty() const {
+    load_header();
+    return number_of_entries == 0;
+}
+
+template<typename indexing>
+bool directory<indexing>::take_resized() const {
+    return resized.exchange(false);
+}
+
+template<typename indexing>
+size_t directory<indexing>::memory_usage() const {
+    // Each node has a next pointer and a cached hash besides its bucket
+    constexpr size_t node_overhead = 2 * sizeof(void*);
+
+    if (!header_loaded.load(std::memory_order_acquire)) {
+        return sizeof(directory);
+    }
+
+    auto structure_lock = std::shared_lock(*structure_mutex);
+    size_t result = sizeof(directory) + fragments.size() * (sizeof(fragment) + sizeof(std::mutex) + 4 * sizeof(void*));
+
+    for (const auto& [id, fragment]: fragments) {
+        auto fragment_lock = std::unique_lock(*fragment.mutex);
+        if (fragment.loaded) {
+            result += fragment.image.memory_usage() + (fragment.encoded_image.has_value() ? fragment.encoded_image->memory_usage() : 0);
+            result += fragment.files.size() * (sizeof(directory_entry_type) + node_overhead) + fragment.files.bucket_count() * sizeof(void*);
+            result += fragment.masked_names.size() * (sizeof(std::string) + node_overhead) + fragment.masked_names.bucket_count() * sizeof(void*);
+            for (const auto& content: fragment.files) {
+                result += content.size();
+            }
+        }
+    }
+    return result;
 }
 
 template<typename indexing>
@@ -165,44 +878,124 @@ void directory<indexing>::remove() {
     log::information(log_locations::directory_operation) << std::hex << std::showbase << "(" << &directory_metadata << ") " << __func__ << "()\n";
     auto lock = std::unique_lock(*mutex);
 
+    remove_objects();
+    fragments.clear();
+    removed_fragments.clear();
+    number_of_entries = 0;
+    // Fragments are not data objects in the range of size
+    directory_metadata.size = 0;
     directory_metadata.remove();
     dirty = false;
+    header_dirty = false;
 }
 
 template<typename indexing>
-const typename directory<indexing>::directory_entry_type& directory<indexing>::get_entry(std::string_view file_name) const {
-    auto iterator = std::find_if(files.begin(), files.end(), directory_entry_type::find_by_name(file_name));
-
-    if (iterator != files.end()) {
-        return *iterator;
+typename directory<indexing>::directory_entry_type directory<indexing>::get_entry(std::string_view file_name) const {
+    auto structure_lock = std::shared_lock(*structure_mutex);
+    uint32_t id = locate(file_name);
+    auto fragment_lock = lock_fragment(id);
+    auto entry = find_entry(load(id), file_name);
+
+    if (entry.has_value()) {
+        return std::move(*entry);
     } else {
         throw nmfs::exceptions::file_does_not_exist(file_name);
     }
 }
 
+template<typename indexing>
+bool directory<indexing>::update_entry(directory_entry_type entry) {
+    auto structure_lock = std::shared_lock(*structure_mutex);
+    uint32_t id = locate(entry.file_name);
+    auto fragment_lock = lock_fragment(id);
+    auto& fragment = load_for_update(id);
+    auto old_entry = find_entry(fragment, entry.file_name);
+
+    if (old_entry.has_value()) {
+        auto file_name = entry.file_name;
+        fragment.size -= old_entry->size();
+        fragment.size += entry.size();
+        put_entry(fragment, std::move(entry));
+        entry_updated(fragment, file_name);
+        return true;
+    } else {
+        return false;
+    }
+}
+
 template<typename indexing>
 void directory<indexing>::move_entry(std::string_view old_path, std::string_view new_path, directory& target_directory) {
     std::string_view old_file_name = get_filename(old_path);
     std::string_view new_file_name = get_filename(new_path);
-    auto iterator = std::find_if(files.begin(), files.end(), directory_entry_type::find_by_name(old_file_name));
-
-    if (iterator != files.end()) {
-        size_t entry_size = iterator->size();
-        auto entry = files.extract(iterator);
-        size -= entry_size;
-        dirty = true;
-
-        entry.value().file_name = std::string(new_file_name);
-        entry_size = entry.value().size();
-
-        auto insert_result = target_directory.files.insert(std::move(entry));
-        target_directory.size += entry_size;
-        target_directory.dirty = true;
+    bool same_directory = &target_directory == this;
+    // Callers hold both directories exclusively, but fragments are locked as every other operation on them does
+    auto structure_lock = std::shared_lock(*structure_mutex);
+    auto target_structure_lock = same_directory ? std::shared_lock<std::shared_mutex>() : std::shared_lock(*target_directory.structure_mutex);
+    uint32_t source_id = locate(old_file_name);
+    uint32_t target_id = target_directory.locate(new_file_name);
+    auto source_fragment_lock = lock_fragment(source_id);
+    // A fragment holding both entries is locked once
+    auto target_fragment_lock = same_directory && target_id == source_id ? std::unique_lock<std::mutex>() : target_directory.lock_fragment(target_id);
+    auto& source_fragment = load_for_update(source_id);
+    auto entry = find_entry(source_fragment, old_file_name);
+
+    if (entry.has_value()) {
+        source_fragment.size -= fragment_image<indexing>::record_size(entry->size());
+        source_fragment.number_of_files--;
+        number_of_entries--;
+        erase_entry(source_fragment, old_file_name);
+        entry_removed(source_fragment, old_file_name);
+
+        entry->file_name = std::string(new_file_name);
+
+        auto& target_fragment = target_directory.load_for_update(target_id);
+        // An entry being overwritten is replaced, so it isn't counted twice
+        if (auto overwritten_entry = target_directory.find_entry(target_fragment, new_file_name)) {
+            target_fragment.size -= fragment_image<indexing>::record_size(overwritten_entry->size());
+        } else {
+            target_fragment.number_of_files++;
+            target_directory.number_of_entries++;
+        }
+        target_fragment.size += fragment_image<indexing>::record_size(entry->size());
+        put_entry(target_fragment, std::move(*entry));
+        target_directory.entry_updated(target_fragment, new_file_name);
+
+        if (target_fragment.size > configuration::directory_fragment_size) {
+            target_fragment_lock = std::unique_lock<std::mutex>();
+            source_fragment_lock.unlock();
+            target_structure_lock = std::shared_lock<std::shared_mutex>();
+            structure_lock.unlock();
+            target_directory.split_if_full(new_file_name);
+        }
     } else {
         throw nmfs::exceptions::file_does_not_exist(old_path);
     }
 }
 
+template<typename indexing>
+size_t directory<indexing>::entry_hash::operator()(std::string_view file_name) const {
+    return std::hash<std::string_view>()(file_name);
+}
+
+template<typename indexing>
+size_t directory<indexing>::entry_hash::operator()(const directory_entry_type& entry) const {
+    return operator()(std::string_view(entry.file_name));
+}
+
+template<typename indexing>
+template<typename left_type, typename right_type>
+bool directory<indexing>::entry_equal::operator()(const left_type& left, const right_type& right) const {
+    auto file_name = [](const auto& value) -> std::string_view {
+        if constexpr (std::is_convertible_v<decltype(value), std::string_view>) {
+            return value;
+        } else {
+            return value.file_name;
+        }
+    };
+
+    return file_name(left) == file_name(right);
+}
+
 }
 
 #endif //NMFS_STRUCTURES_DIRECTORY_IMPL_HPP
@@ -19,12 +19,13 @@ public:
 
     inline virtual on_disk_size_type serialize(byte* buffer) const;
     [[nodiscard]] inline virtual size_t size() const;
-    inline virtual void fill(const fuse_directory_filler& filler) const;
+    /**
+     * @return Nonzero if the buffer of filler is full
+     */
+    inline virtual int fill(const fuse_directory_filler& filler, off_t offset = 0) const;
 
     inline virtual bool operator<(const directory_entry& other) const;
     inline virtual bool operator==(const directory_entry& other) const;
-
-    inline static std::function<bool(const directory_entry&)> find_by_name(std::string_view file_name);
 };
 
 }
@@ -34,15 +34,8 @@ size_t directory_entry<indexing>::size() const {
 }
 
 template<typename indexing>
-void directory_entry<indexing>::fill(const fuse_directory_filler& filler) const {
-    filler(file_name.c_str());
-}
-
-template<typename indexing>
-std::function<bool(const directory_entry<indexing>&)> directory_entry<indexing>::find_by_name(std::string_view file_name) {
-    return [file_name] (const directory_entry& other) {
-        return file_name == other.file_name;
-    };
+int directory_entry<indexing>::fill(const fuse_directory_filler& filler, off_t offset) const {
+    return filler(file_name.c_str(), offset);
 }
 
 template<typename indexing>
@@ -0,0 +1,94 @@
+#ifndef NMFS_STRUCTURES_FRAGMENT_IMAGE_HPP
+#define NMFS_STRUCTURES_FRAGMENT_IMAGE_HPP
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../memory_slices/owner_slice.hpp"
+#include "../primitive_types.hpp"
+#include "on_disk/directory.hpp"
+
+namespace nmfs::structures {
+
+/**
+ * Entries of a directory fragment, read in place from the object they were loaded from
+ *
+ * Entries are sorted by file name, and each file name is stored without the prefix it shares with the previous one.
+ * Restart points store whole file names, so a lookup is a binary search over restart points followed by a scan of
+ * at most restart_interval entries, and loading costs one read and no allocation per entry.
+ */
+template<typename indexing>
+class fragment_image {
+public:
+    using directory_entry_type = typename indexing::directory_entry_type;
+
+    /**
+     * File name of an entry, and the rest of its serialized form
+     */
+    struct record {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    inline fragment_image();
+    /**
+     * @param object Whole object of a fragment, including changes appended after the image
+     */
+    explicit inline fragment_image(owner_slice object);
+    fragment_image(const fragment_image&) = delete;
+    fragment_image(fragment_image&&) noexcept = default;
+    fragment_image& operator=(fragment_image&&) noexcept = default;
+
+    [[nodiscard]] constexpr size_t number_of_entries() const;
+    /**
+     * Visit records in the order of file names, whose names are valid only during the call
+     */
+    template<typename function_type>
+    inline void for_each(function_type function) const;
+    [[nodiscard]] inline std::optional<directory_entry_type> find(std::string_view file_name) const;
+    /**
+     * Changes appended to the object after the image, each of which begins with on_disk::fragment_change
+     */
+    [[nodiscard]] inline std::string_view changes() const;
+    /**
+     * Number of bytes of the object, where next changes are appended
+     */
+    [[nodiscard]] constexpr size_t object_size() const;
+    [[nodiscard]] constexpr size_t memory_usage() const;
+
+    /**
+     * Encode records sorted by file name
+     */
+    [[nodiscard]] static inline owner_slice encode(const std::vector<record>& records);
+    /**
+     * Split a serialized entry into its file name and the rest
+     */
+    [[nodiscard]] static inline record split(std::string_view serialized_entry);
+    [[nodiscard]] static inline directory_entry_type decode(const record& record);
+    /**
+     * Number of bytes a record takes in an encoded image before its file name is compressed
+     */
+    [[nodiscard]] static constexpr size_t record_size(size_t serialized_size);
+
+private:
+    owner_slice object;
+    on_disk_size_type entries;
+    size_t image_size;
+    size_t restart_interval;
+    const on_disk_size_type* restarts;
+
+    [[nodiscard]] constexpr size_t number_of_restarts() const;
+    /**
+     * File name of a restart point, which is stored whole
+     */
+    [[nodiscard]] inline std::string_view restart_name(size_t index) const;
+    /**
+     * Read the record at current, whose file name is completed in name from the previous one
+     */
+    inline record read(const byte*& current, std::string& name) const;
+};
+
+}
+
+#endif //NMFS_STRUCTURES_FRAGMENT_IMAGE_HPP
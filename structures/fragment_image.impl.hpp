@@ -0,0 +1,214 @@
+#ifndef NMFS_STRUCTURES_FRAGMENT_IMAGE_IMPL_HPP
+#define NMFS_STRUCTURES_FRAGMENT_IMAGE_IMPL_HPP
+
+#include <algorithm>
+#include "fragment_image.hpp"
+#include "../configuration.hpp"
+#include "../exceptions/unsupported_format.hpp"
+
+namespace nmfs::structures {
+
+template<typename indexing>
+fragment_image<indexing>::fragment_image()
+    : object(0),
+      entries(0),
+      image_size(0),
+      restart_interval(configuration::directory_restart_interval),
+      restarts(nullptr) {
+}
+
+template<typename indexing>
+fragment_image<indexing>::fragment_image(owner_slice object)
+    : object(std::move(object)),
+      entries(0),
+      image_size(0),
+      restart_interval(configuration::directory_restart_interval),
+      restarts(nullptr) {
+    if (this->object.size() < sizeof(on_disk::fragment_image)) {
+        throw nmfs::exceptions::unsupported_format("directory fragment", 0);
+    }
+
+    auto header = reinterpret_cast<const on_disk::fragment_image*>(this->object.data());
+    if (header->magic != on_disk::fragment_image::current_magic || header->version != on_disk::fragment_image::current_version || header->restart_interval == 0) {
+        throw nmfs::exceptions::unsupported_format("directory fragment", header->magic == on_disk::fragment_image::current_magic ? header->version : 0);
+    }
+
+    entries = header->number_of_entries;
+    image_size = header->image_size;
+    restart_interval = header->restart_interval;
+    restarts = reinterpret_cast<const on_disk_size_type*>(this->object.data() + sizeof(on_disk::fragment_image));
+}
+
+template<typename indexing>
+constexpr size_t fragment_image<indexing>::number_of_entries() const {
+    return entries;
+}
+
+template<typename indexing>
+template<typename function_type>
+void fragment_image<indexing>::for_each(function_type function) const {
+    const byte* current = object.data() + (entries > 0 ? restarts[0] : 0);
+    std::string name;
+
+    for (size_t i = 0; i < entries; i++) {
+        function(read(current, name));
+    }
+}
+
+template<typename indexing>
+std::optional<typename fragment_image<indexing>::directory_entry_type> fragment_image<indexing>::find(std::string_view file_name) const {
+    if (entries == 0 || file_name < restart_name(0)) {
+        return std::nullopt;
+    }
+
+    // Last restart point whose file name is not greater than file_name
+    size_t begin = 0;
+    size_t end = number_of_restarts();
+    while (end - begin > 1) {
+        size_t middle = begin + (end - begin) / 2;
+
+        if (restart_name(middle) <= file_name) {
+            begin = middle;
+        } else {
+            end = middle;
+        }
+    }
+
+    const byte* current = object.data() + restarts[begin];
+    std::string name;
+
+    for (size_t i = begin * restart_interval; i < std::min<size_t>(entries, (begin + 1) * restart_interval); i++) {
+        auto record = read(current, name);
+        int comparison = record.name.compare(file_name);
+
+        if (comparison == 0) {
+            return decode(record);
+        } else if (comparison > 0) {
+            break;
+        }
+    }
+    return std::nullopt;
+}
+
+template<typename indexing>
+std::string_view fragment_image<indexing>::changes() const {
+    return image_size < object.size() ? std::string_view(object.data() + image_size, object.size() - image_size) : std::string_view();
+}
+
+template<typename indexing>
+constexpr size_t fragment_image<indexing>::object_size() const {
+    return object.size();
+}
+
+template<typename indexing>
+constexpr size_t fragment_image<indexing>::memory_usage() const {
+    return sizeof(fragment_image) + object.capacity();
+}
+
+template<typename indexing>
+owner_slice fragment_image<indexing>::encode(const std::vector<record>& records) {
+    const size_t interval = configuration::directory_restart_interval;
+    const size_t number_of_restarts = (records.size() + interval - 1) / interval;
+    std::vector<uint16_t> shared_sizes(records.size());
+    size_t size = sizeof(on_disk::fragment_image) + number_of_restarts * sizeof(on_disk_size_type);
+
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i % interval != 0) {
+            const auto& previous = records[i - 1].name;
+            const auto& current = records[i].name;
+            size_t limit = std::min<size_t>({previous.size(), current.size(), UINT16_MAX});
+            shared_sizes[i] = std::mismatch(current.begin(), current.begin() + limit, previous.begin()).first - current.begin();
+        }
+        size += sizeof(on_disk::fragment_record) + records[i].name.size() - shared_sizes[i] + records[i].value.size();
+    }
+
+    auto object = owner_slice(size);
+    auto header = reinterpret_cast<on_disk::fragment_image*>(object.data());
+    auto restart_table = reinterpret_cast<on_disk_size_type*>(object.data() + sizeof(on_disk::fragment_image));
+    byte* current = reinterpret_cast<byte*>(restart_table + number_of_restarts);
+
+    *header = on_disk::fragment_image {
+        .magic = on_disk::fragment_image::current_magic,
+        .version = on_disk::fragment_image::current_version,
+        .number_of_entries = static_cast<on_disk_size_type>(records.size()),
+        .image_size = static_cast<on_disk_size_type>(size),
+        .restart_interval = static_cast<uint32_t>(interval),
+    };
+    for (size_t i = 0; i < records.size(); i++) {
+        const auto& [name, value] = records[i];
+
+        if (i % interval == 0) {
+            restart_table[i / interval] = current - object.data();
+        }
+        *reinterpret_cast<on_disk::fragment_record*>(current) = on_disk::fragment_record {
+            .shared_size = shared_sizes[i],
+            .unshared_size = static_cast<uint16_t>(name.size() - shared_sizes[i]),
+            .value_size = static_cast<uint16_t>(value.size()),
+        };
+        current += sizeof(on_disk::fragment_record);
+        current = std::copy(name.begin() + shared_sizes[i], name.end(), current);
+        current = std::copy(value.begin(), value.end(), current);
+    }
+
+    return object;
+}
+
+template<typename indexing>
+typename fragment_image<indexing>::record fragment_image<indexing>::split(std::string_view serialized_entry) {
+    on_disk_size_type file_name_length = *reinterpret_cast<const on_disk_size_type*>(serialized_entry.data());
+
+    return record {
+        .name = serialized_entry.substr(sizeof(on_disk_size_type), file_name_length),
+        .value = serialized_entry.substr(sizeof(on_disk_size_type) + file_name_length),
+    };
+}
+
+template<typename indexing>
+typename fragment_image<indexing>::directory_entry_type fragment_image<indexing>::decode(const record& record) {
+    auto buffer = owner_slice(sizeof(on_disk_size_type) + record.name.size() + record.value.size());
+    byte* current = buffer.data();
+
+    *reinterpret_cast<on_disk_size_type*>(current) = record.name.size();
+    current += sizeof(on_disk_size_type);
+    current = std::copy(record.name.begin(), record.name.end(), current);
+    std::copy(record.value.begin(), record.value.end(), current);
+
+    const byte* serialized = buffer.data();
+    return directory_entry_type(&serialized);
+}
+
+template<typename indexing>
+constexpr size_t fragment_image<indexing>::record_size(size_t serialized_size) {
+    return sizeof(on_disk::fragment_record) + serialized_size - sizeof(on_disk_size_type);
+}
+
+template<typename indexing>
+constexpr size_t fragment_image<indexing>::number_of_restarts() const {
+    return (entries + restart_interval - 1) / restart_interval;
+}
+
+template<typename indexing>
+std::string_view fragment_image<indexing>::restart_name(size_t index) const {
+    const byte* current = object.data() + restarts[index];
+    auto header = reinterpret_cast<const on_disk::fragment_record*>(current);
+
+    return std::string_view(current + sizeof(on_disk::fragment_record), header->unshared_size);
+}
+
+template<typename indexing>
+typename fragment_image<indexing>::record fragment_image<indexing>::read(const byte*& current, std::string& name) const {
+    auto header = reinterpret_cast<const on_disk::fragment_record*>(current);
+    current += sizeof(on_disk::fragment_record);
+
+    name.resize(header->shared_size);
+    name.append(current, header->unshared_size);
+    current += header->unshared_size;
+
+    auto value = std::string_view(current, header->value_size);
+    current += header->value_size;
+    return record { .name = name, .value = value };
+}
+
+}
+
+#endif //NMFS_STRUCTURES_FRAGMENT_IMAGE_IMPL_HPP
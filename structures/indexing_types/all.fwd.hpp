@@ -1,7 +1,9 @@
 #ifndef NMFS_STRUCTURES_INDEXING_TYPES_ALL_FWD_HPP
 #define NMFS_STRUCTURES_INDEXING_TYPES_ALL_FWD_HPP
 
-namespace nmfs::structures::indexing_types::custom { class indexing; }
-namespace nmfs::structures::indexing_types::full_path { class indexing; }
+namespace nmfs::structures::indexing_types::custom { template<template<typename> typename caching_policy_type> class indexing; }
+namespace nmfs::structures::indexing_types::full_path { template<template<typename> typename caching_policy_type> class indexing; }
+namespace nmfs::structures::indexing_types::inline_attributes { template<template<typename> typename caching_policy_type> class indexing; }
+namespace nmfs::structures::indexing_types::inode { template<template<typename> typename caching_policy_type> class indexing; }
 
 #endif //NMFS_STRUCTURES_INDEXING_TYPES_ALL_FWD_HPP
@@ -3,5 +3,7 @@
 
 #include "custom/indexing.hpp"
 #include "full_path/indexing.hpp"
+#include "inline_attributes/indexing.hpp"
+#include "inode/indexing.hpp"
 
 #endif //NMFS_STRUCTURES_INDEXING_TYPES_ALL_HPP
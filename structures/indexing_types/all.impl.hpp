@@ -3,5 +3,7 @@
 
 #include "full_path/indexing.impl.hpp"
 #include "custom/indexing.impl.hpp"
+#include "inline_attributes/indexing.impl.hpp"
+#include "inode/indexing.impl.hpp"
 
 #endif //NMFS_STRUCTURES_INDEXING_TYPES_ALL_IMPL_HPP
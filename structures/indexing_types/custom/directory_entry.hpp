@@ -6,6 +6,7 @@
 
 namespace nmfs::structures::indexing_types::custom {
 
+template<typename indexing>
 class directory_entry: public nmfs::structures::directory_entry<indexing> {
 public:
     uuid_t uuid{};
@@ -16,6 +17,7 @@ public:
 
     inline on_disk_size_type serialize(byte* buffer) const override;
     [[nodiscard]] inline size_t size() const override;
+    inline int fill(const fuse_directory_filler& filler, off_t offset = 0) const override;
 };
 
 }
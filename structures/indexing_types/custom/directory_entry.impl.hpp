@@ -9,14 +9,16 @@
 
 namespace nmfs::structures::indexing_types::custom {
 
-directory_entry::directory_entry(std::string file_name, const nmfs::structures::metadata<indexing>& metadata)
+template<typename indexing>
+directory_entry<indexing>::directory_entry(std::string file_name, const nmfs::structures::metadata<indexing>& metadata)
     : nmfs::structures::directory_entry<indexing>(std::move(file_name), metadata), type(metadata.mode & S_IFMT) {
-    auto& custom_metadata = dynamic_cast<const nmfs::structures::indexing_types::custom::metadata&>(metadata);
+    auto& custom_metadata = dynamic_cast<const nmfs::structures::indexing_types::custom::metadata<indexing>&>(metadata);
 
     std::copy(custom_metadata.data_key_base.data(), custom_metadata.data_key_base.data() + sizeof(uuid_t), uuid);
 }
 
-directory_entry::directory_entry(const byte** buffer): nmfs::structures::directory_entry<indexing>(buffer) {
+template<typename indexing>
+directory_entry<indexing>::directory_entry(const byte** buffer): nmfs::structures::directory_entry<indexing>(buffer) {
     std::copy(*buffer, (*buffer) + sizeof(uuid_t), uuid);
     (*buffer) += sizeof(uuid_t);
 
@@ -24,7 +26,8 @@ directory_entry::directory_entry(const byte** buffer): nmfs::structures::directo
     (*buffer) += sizeof(uint32_t);
 }
 
-on_disk_size_type directory_entry::serialize(byte* buffer) const {
+template<typename indexing>
+on_disk_size_type directory_entry<indexing>::serialize(byte* buffer) const {
     byte* current = buffer + nmfs::structures::directory_entry<indexing>::serialize(buffer);
 
     std::copy(uuid, uuid + sizeof(uuid), current);
@@ -36,10 +39,16 @@ on_disk_size_type directory_entry::serialize(byte* buffer) const {
     return current - buffer;
 }
 
-size_t directory_entry::size() const {
+template<typename indexing>
+size_t directory_entry<indexing>::size() const {
     return nmfs::structures::directory_entry<indexing>::size() + sizeof(uuid_t) + sizeof(uint32_t);
 }
 
+template<typename indexing>
+int directory_entry<indexing>::fill(const fuse_directory_filler& filler, off_t offset) const {
+    return filler(this->file_name.c_str(), type, offset);
+}
+
 }
 
 #endif //NMFS_STRUCTURES_INDEXING_TYPES_CUSTOM_DIRECTORY_ENTRY_IMPL_HPP
@@ -6,6 +6,7 @@
 
 namespace nmfs::structures::indexing_types::custom {
 
+template<typename indexing>
 class metadata: public nmfs::structures::metadata<indexing> {
 public:
     owner_slice data_key_base;
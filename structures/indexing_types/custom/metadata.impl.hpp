@@ -4,78 +4,78 @@
 #include <algorithm>
 #include "../../../memory_slices/borrower_slice.hpp"
 #include "../../../utils.hpp"
-#include "../../../kv_backends/exceptions/key_does_not_exist.hpp"
 #include "metadata.hpp"
 
 #include "../../metadata.impl.hpp"
 
 namespace nmfs::structures::indexing_types::custom {
 
-metadata::metadata(nmfs::structures::super_object<indexing>& super, nmfs::owner_slice key, uid_t owner, gid_t group, mode_t mode)
+template<typename indexing>
+metadata<indexing>::metadata(nmfs::structures::super_object<indexing>& super, nmfs::owner_slice key, uid_t owner, gid_t group, mode_t mode)
     : nmfs::structures::metadata<indexing>(super, std::move(key), owner, group, mode),
       data_key_base(generate_uuid()) {
 }
 
-metadata::metadata(nmfs::structures::super_object<indexing>& super, nmfs::owner_slice key, const nmfs::structures::on_disk::metadata* on_disk_data)
+template<typename indexing>
+metadata<indexing>::metadata(nmfs::structures::super_object<indexing>& super, nmfs::owner_slice key, const nmfs::structures::on_disk::metadata* on_disk_data)
     : nmfs::structures::metadata<indexing>(super, std::move(key), on_disk_data),
       data_key_base(sizeof(uuid_t)) {
     auto custom_on_disk_data = static_cast<const nmfs::structures::indexing_types::custom::on_disk::metadata*>(on_disk_data);
     std::copy(custom_on_disk_data->uuid, custom_on_disk_data->uuid + sizeof(uuid_t), data_key_base.data());
 }
 
-metadata::metadata(metadata&& other, nmfs::owner_slice key)
+template<typename indexing>
+metadata<indexing>::metadata(metadata&& other, nmfs::owner_slice key)
     : nmfs::structures::metadata<indexing>(std::move(other), std::move(key), other.data_key_base),
       data_key_base(std::move(other.data_key_base)) {
 }
 
-metadata::~metadata() {
+template<typename indexing>
+metadata<indexing>::~metadata() {
     metadata::flush();
 }
 
-void metadata::flush() const {
-    if (valid && dirty) {
+template<typename indexing>
+void metadata<indexing>::flush() const {
+    auto flush_lock = std::unique_lock(*this->flush_mutex);
+    // Cleared first, so changes made while writing mark this metadata dirty again
+    if (this->valid && this->dirty.exchange(false)) {
         nmfs::structures::indexing_types::custom::on_disk::metadata on_disk_structure {};
         to_on_disk_metadata(on_disk_structure);
 
         auto value = borrower_slice(&on_disk_structure, sizeof(on_disk_structure));
 
-        context.backend->put(key, value);
-        dirty = false;
+        try {
+            this->context.backend->put(this->key, value);
+        } catch (...) {
+            // Written again by the next flush
+            this->dirty = true;
+            throw;
+        }
     }
 }
 
-void metadata::reload() {
+template<typename indexing>
+void metadata<indexing>::reload() {
     // TODO
 }
 
-void metadata::move_data(const nmfs::slice& new_data_key_base) {
+template<typename indexing>
+void metadata<indexing>::move_data(const nmfs::slice& new_data_key_base) {
     if (data_key_base != new_data_key_base) {
-        auto old_data_key = nmfs::structures::utils::data_object_key(data_key_base, 0);
-        auto new_data_key = nmfs::structures::utils::data_object_key(new_data_key_base, 0);
-
-        for (size_t i = 0; i < size / context.maximum_object_size; i++) {
-            try {
-                owner_slice data = context.backend->get(old_data_key);
-                context.backend->remove(old_data_key);
-                context.backend->put(new_data_key, data);
-
-                old_data_key.increase_index();
-                new_data_key.increase_index();
-            } catch (nmfs::kv_backends::exceptions::key_does_not_exist&) {
-                continue;
-            }
-        }
-
+        this->move_data_objects(data_key_base, new_data_key_base);
         data_key_base = owner_slice(new_data_key_base.size());
         std::copy(new_data_key_base.cbegin(), new_data_key_base.cend(), data_key_base.data());
     }
 }
 
-nmfs::structures::utils::data_object_key metadata::get_data_object_key(uint32_t index) const {
+template<typename indexing>
+nmfs::structures::utils::data_object_key metadata<indexing>::get_data_object_key(uint32_t index) const {
     return nmfs::structures::utils::data_object_key(data_key_base, index);
 }
 
-void metadata::to_on_disk_metadata(nmfs::structures::indexing_types::custom::on_disk::metadata& on_disk_metadata) const {
+template<typename indexing>
+void metadata<indexing>::to_on_disk_metadata(nmfs::structures::indexing_types::custom::on_disk::metadata& on_disk_metadata) const {
     nmfs::structures::metadata<indexing>::to_on_disk_metadata(on_disk_metadata);
     std::copy(data_key_base.data(), data_key_base.data() + sizeof(uuid_t), on_disk_metadata.uuid);
 }
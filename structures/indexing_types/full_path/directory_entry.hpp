@@ -6,6 +6,7 @@
 
 namespace nmfs::structures::indexing_types::full_path {
 
+template<typename indexing>
 class directory_entry: public nmfs::structures::directory_entry<indexing> {
 public:
     inline directory_entry(std::string file_name, const nmfs::structures::metadata<indexing>& metadata);
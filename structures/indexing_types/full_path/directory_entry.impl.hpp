@@ -6,11 +6,13 @@
 
 namespace nmfs::structures::indexing_types::full_path {
 
-directory_entry::directory_entry(std::string file_name, const nmfs::structures::metadata<indexing>& metadata)
+template<typename indexing>
+directory_entry<indexing>::directory_entry(std::string file_name, const nmfs::structures::metadata<indexing>& metadata)
     : nmfs::structures::directory_entry<indexing>(std::move(file_name), metadata) {
 }
 
-directory_entry::directory_entry(const byte** buffer)
+template<typename indexing>
+directory_entry<indexing>::directory_entry(const byte** buffer)
     : nmfs::structures::directory_entry<indexing>(buffer) {
 }
 
@@ -6,33 +6,59 @@
 #include "directory_entry.impl.hpp"
 #include "metadata.impl.hpp"
 #include "../../../local_caches/cache_store.impl.hpp"
+#include "../../utils/read_metadata.hpp"
 
 namespace nmfs::structures::indexing_types::full_path {
 
-borrower_slice indexing::existing_directory_key(super_object<indexing>& context, std::string_view path) {
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::existing_directory_key(super_object<indexing>& context, std::string_view path) {
     DECLARE_CONST_BORROWER_SLICE(slice, path.data(), path.size());
     return slice;
 }
 
-borrower_slice indexing::existing_regular_file_key(super_object<indexing>& context, std::string_view path) {
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::existing_regular_file_key(super_object<indexing>& context, std::string_view path) {
     return existing_directory_key(context, path);
 }
 
-borrower_slice indexing::new_directory_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
+template<template<typename> typename caching_policy_type>
+owner_slice indexing<caching_policy_type>::existing_entry_key(super_object<indexing>& context, std::string_view path, const directory_entry_type& entry) {
+    return owner_slice(existing_directory_key(context, path));
+}
+
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::new_directory_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
     return existing_directory_key(context, path);
 }
 
-borrower_slice indexing::new_regular_file_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::new_regular_file_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
     return existing_directory_key(context, path);
 }
 
-mode_t indexing::get_type(super_object<indexing>& context, std::string_view path) {
-    auto open_context = context.cache->open<std::shared_lock>(path);
+template<template<typename> typename caching_policy_type>
+mode_t indexing<caching_policy_type>::get_type(super_object<indexing>& context, std::string_view path) {
+    auto open_context = context.cache->template open<std::shared_lock>(path);
     mode_t mode = open_context.metadata.mode;
 
     return mode;
 }
 
+template<template<typename> typename caching_policy_type>
+typename indexing<caching_policy_type>::metadata_type indexing<caching_policy_type>::load_directory_metadata(super_object<indexing>& context, std::string_view path) {
+    return utils::read_metadata(context, owner_slice(existing_directory_key(context, path)));
+}
+
+template<template<typename> typename caching_policy_type>
+typename indexing<caching_policy_type>::metadata_type indexing<caching_policy_type>::load_regular_file_metadata(super_object<indexing>& context, std::string_view path) {
+    return utils::read_metadata(context, owner_slice(existing_regular_file_key(context, path)));
+}
+
+template<template<typename> typename caching_policy_type>
+std::optional<struct stat> indexing<caching_policy_type>::entry_attributes(const directory_entry_type& entry) {
+    return std::nullopt;
+}
+
 }
 
 #endif //NMFS_STRUCTURES_INDEXING_TYPES_FULL_PATH_INDEXING_IMPL_HPP
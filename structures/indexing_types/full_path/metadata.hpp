@@ -5,6 +5,7 @@
 
 namespace nmfs::structures::indexing_types::full_path {
 
+template<typename indexing>
 class metadata: public nmfs::structures::metadata<indexing> {
 public:
     metadata(super_object<indexing>& super, owner_slice key, uid_t owner, gid_t group, mode_t mode);
@@ -0,0 +1,30 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_DIRECTORY_ENTRY_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_DIRECTORY_ENTRY_HPP
+
+#include "../custom/directory_entry.hpp"
+#include "../../on_disk/metadata.hpp"
+
+namespace nmfs::structures::indexing_types::inline_attributes {
+
+/**
+ * Directory entry of custom indexing with the attribute block of the file
+ *
+ * Attributes of a regular file are kept only here. Those of a directory are copied when the entry is made, and its
+ * own metadata object stays authoritative.
+ */
+template<typename indexing>
+class directory_entry: public nmfs::structures::indexing_types::custom::directory_entry<indexing> {
+public:
+    nmfs::structures::on_disk::metadata attributes{};
+
+    inline directory_entry(std::string file_name, const nmfs::structures::metadata<indexing>& metadata);
+    inline explicit directory_entry(const byte** buffer);
+
+    inline on_disk_size_type serialize(byte* buffer) const override;
+    [[nodiscard]] inline size_t size() const override;
+    [[nodiscard]] constexpr struct stat to_stat() const;
+};
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_DIRECTORY_ENTRY_HPP
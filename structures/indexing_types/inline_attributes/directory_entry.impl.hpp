@@ -0,0 +1,65 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_DIRECTORY_ENTRY_IMPL_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_DIRECTORY_ENTRY_IMPL_HPP
+
+#include <algorithm>
+#include "directory_entry.hpp"
+
+#include "../custom/directory_entry.impl.hpp"
+#include "metadata.impl.hpp"
+
+namespace nmfs::structures::indexing_types::inline_attributes {
+
+template<typename indexing>
+directory_entry<indexing>::directory_entry(std::string file_name, const nmfs::structures::metadata<indexing>& metadata)
+    : nmfs::structures::indexing_types::custom::directory_entry<indexing>(std::move(file_name), metadata) {
+    attributes.link_count = metadata.link_count;
+    attributes.owner = metadata.owner;
+    attributes.group = metadata.group;
+    attributes.mode = metadata.mode;
+    attributes.size = metadata.size;
+    attributes.atime = metadata.atime;
+    attributes.mtime = metadata.mtime;
+    attributes.ctime = metadata.ctime;
+}
+
+template<typename indexing>
+directory_entry<indexing>::directory_entry(const byte** buffer)
+    : nmfs::structures::indexing_types::custom::directory_entry<indexing>(buffer) {
+    std::copy(*buffer, (*buffer) + sizeof(attributes), reinterpret_cast<byte*>(&attributes));
+    (*buffer) += sizeof(attributes);
+}
+
+template<typename indexing>
+on_disk_size_type directory_entry<indexing>::serialize(byte* buffer) const {
+    byte* current = buffer + nmfs::structures::indexing_types::custom::directory_entry<indexing>::serialize(buffer);
+
+    std::copy(reinterpret_cast<const byte*>(&attributes), reinterpret_cast<const byte*>(&attributes) + sizeof(attributes), current);
+    current += sizeof(attributes);
+
+    return current - buffer;
+}
+
+template<typename indexing>
+size_t directory_entry<indexing>::size() const {
+    return nmfs::structures::indexing_types::custom::directory_entry<indexing>::size() + sizeof(attributes);
+}
+
+template<typename indexing>
+constexpr struct stat directory_entry<indexing>::to_stat() const {
+    struct stat stat{
+        .st_nlink = attributes.link_count,
+        .st_mode = attributes.mode,
+        .st_uid = attributes.owner,
+        .st_gid = attributes.group,
+        .st_size = static_cast<off_t>(attributes.size),
+        .st_atim = attributes.atime,
+        .st_mtim = attributes.mtime,
+        .st_ctim = attributes.ctime,
+    };
+
+    return stat;
+}
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_DIRECTORY_ENTRY_IMPL_HPP
@@ -0,0 +1,59 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_INDEXING_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_INDEXING_HPP
+
+#include <optional>
+#include <string_view>
+#include <sys/stat.h>
+#include "../../../utils.hpp"
+#include "../../../memory_slices/borrower_slice.hpp"
+#include "../../super_object.hpp"
+#include "../../../local_caches/cache_store.hpp"
+#include "../custom/on_disk/metadata.hpp"
+#include "directory_entry.hpp"
+#include "metadata.hpp"
+
+namespace nmfs::structures::indexing_types::inline_attributes {
+
+/**
+ * Custom indexing which keeps attributes of regular files in the entries of their parent directory
+ *
+ * Regular files have no metadata object, so a directory object serves stat of all of its regular files.
+ * Directories are stored as in custom indexing.
+ */
+template<template<typename> typename caching_policy_type>
+class indexing {
+public:
+    using caching_policy = caching_policy_type<indexing>;
+    using directory_entry_type = nmfs::structures::indexing_types::inline_attributes::directory_entry<indexing>;
+    using metadata_type = nmfs::structures::indexing_types::inline_attributes::metadata<indexing>;
+    using on_disk_metadata_type = nmfs::structures::indexing_types::custom::on_disk::metadata;
+
+    /**
+     * Keys depend on paths, so renaming moves objects of every entry under the renamed path
+     */
+    static constexpr bool path_keyed = true;
+    /**
+     * Attributes of regular files are durable once the entries of their parent directory are written
+     */
+    static constexpr bool attributes_in_entries = true;
+
+    static inline borrower_slice existing_directory_key(super_object<indexing>& context, std::string_view path);
+    static inline owner_slice existing_regular_file_key(super_object<indexing>& context, std::string_view path);
+    /**
+     * Key of an existing file, generated from its entry without opening the parent directory
+     */
+    static inline owner_slice existing_entry_key(super_object<indexing>& context, std::string_view path, const directory_entry_type& entry);
+    static inline borrower_slice new_directory_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata);
+    static inline borrower_slice new_regular_file_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata);
+    static inline mode_t get_type(super_object<indexing>& context, std::string_view path);
+    static inline metadata_type load_directory_metadata(super_object<indexing>& context, std::string_view path);
+    static inline metadata_type load_regular_file_metadata(super_object<indexing>& context, std::string_view path);
+    /**
+     * Attributes kept in a directory entry, or std::nullopt if they are only in the metadata object
+     */
+    static inline std::optional<struct stat> entry_attributes(const directory_entry_type& entry);
+};
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_INDEXING_HPP
@@ -0,0 +1,109 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_INDEXING_IMPL_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_INDEXING_IMPL_HPP
+
+#include <algorithm>
+
+#include "indexing.hpp"
+#include "../../super_object.impl.hpp"
+#include "../../../local_caches/cache_store.impl.hpp"
+#include "directory_entry.impl.hpp"
+#include "metadata.impl.hpp"
+#include "../../utils/read_metadata.hpp"
+
+namespace nmfs::structures::indexing_types::inline_attributes {
+
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::existing_directory_key(super_object<indexing>& context, std::string_view path) {
+    DECLARE_CONST_BORROWER_SLICE(slice, path.data(), path.size());
+    return slice;
+}
+
+template<template<typename> typename caching_policy_type>
+owner_slice indexing<caching_policy_type>::existing_regular_file_key(super_object<indexing>& context, std::string_view path) {
+    std::string_view parent_path = get_parent_directory(path);
+    std::string_view file_name = get_filename(path);
+    auto open_context = context.cache->template open_directory<std::shared_lock>(parent_path);
+    auto entry = open_context.directory.get_entry(file_name);
+
+    return existing_entry_key(context, path, entry);
+}
+
+template<template<typename> typename caching_policy_type>
+owner_slice indexing<caching_policy_type>::existing_entry_key(super_object<indexing>& context, std::string_view path, const directory_entry_type& entry) {
+    if (S_ISDIR(entry.type)) {
+        return owner_slice(existing_directory_key(context, path));
+    } else {
+        auto key = owner_slice(sizeof(uuid_t));
+
+        std::copy(entry.uuid, entry.uuid + sizeof(uuid_t), key.data());
+        return key;
+    }
+}
+
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::new_directory_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
+    metadata.path = std::string(path);
+    return existing_directory_key(context, path);
+}
+
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::new_regular_file_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
+    metadata.path = std::string(path);
+    return borrower_slice(metadata.data_key_base.data(), metadata.data_key_base.size());
+}
+
+template<template<typename> typename caching_policy_type>
+mode_t indexing<caching_policy_type>::get_type(super_object<indexing>& context, std::string_view path) {
+    if (path == "/") {
+        return S_IFDIR;
+    } else {
+        std::string_view parent_path = get_parent_directory(path);
+        std::string_view file_name = get_filename(path);
+        auto open_context = context.cache->template open_directory<std::shared_lock>(parent_path);
+        auto entry = open_context.directory.get_entry(file_name);
+
+        return entry.type;
+    }
+}
+
+template<template<typename> typename caching_policy_type>
+typename indexing<caching_policy_type>::metadata_type indexing<caching_policy_type>::load_directory_metadata(super_object<indexing>& context, std::string_view path) {
+    auto metadata = utils::read_metadata(context, owner_slice(existing_directory_key(context, path)));
+
+    metadata.path = std::string(path);
+    return metadata;
+}
+
+template<template<typename> typename caching_policy_type>
+typename indexing<caching_policy_type>::metadata_type indexing<caching_policy_type>::load_regular_file_metadata(super_object<indexing>& context, std::string_view path) {
+    auto load_from = [&context, path](const directory_entry_type& entry) {
+        on_disk_metadata_type on_disk_metadata {};
+        static_cast<nmfs::structures::on_disk::metadata&>(on_disk_metadata) = entry.attributes;
+        std::copy(entry.uuid, entry.uuid + sizeof(uuid_t), on_disk_metadata.uuid);
+
+        auto metadata = metadata_type(context, existing_entry_key(context, path, entry), &on_disk_metadata);
+        metadata.path = std::string(path);
+        return metadata;
+    };
+
+    // Entry flushed recently may not be applied to the parent directory yet
+    if (auto pending = context.cache->pending_entry(path)) {
+        return load_from(*pending);
+    } else {
+        auto open_context = context.cache->template open_directory<std::shared_lock>(get_parent_directory(path));
+        return load_from(open_context.directory.get_entry(get_filename(path)));
+    }
+}
+
+template<template<typename> typename caching_policy_type>
+std::optional<struct stat> indexing<caching_policy_type>::entry_attributes(const directory_entry_type& entry) {
+    if (S_ISREG(entry.type)) {
+        return entry.to_stat();
+    } else {
+        return std::nullopt;
+    }
+}
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_INDEXING_IMPL_HPP
@@ -0,0 +1,31 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_METADATA_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_METADATA_HPP
+
+#include <string>
+#include "../custom/metadata.hpp"
+
+namespace nmfs::structures::indexing_types::inline_attributes {
+
+/**
+ * Metadata of custom indexing whose regular files are flushed into the entry of their parent directory
+ */
+template<typename indexing>
+class metadata: public nmfs::structures::indexing_types::custom::metadata<indexing> {
+public:
+    /**
+     * Path of this file, which is set by indexing when the metadata is loaded, created or moved
+     */
+    std::string path;
+
+    metadata(super_object<indexing>& super, owner_slice key, uid_t owner, gid_t group, mode_t mode);
+    metadata(super_object<indexing>& super, owner_slice key, const nmfs::structures::on_disk::metadata* on_disk_data);
+    metadata(metadata&& other, owner_slice key);
+    metadata(metadata&& other) noexcept = default;
+    ~metadata() override;
+
+    void flush() const override;
+};
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_METADATA_HPP
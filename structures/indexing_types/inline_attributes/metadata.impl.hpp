@@ -0,0 +1,48 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_METADATA_IMPL_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_METADATA_IMPL_HPP
+
+#include "../../../utils.hpp"
+#include "metadata.hpp"
+
+#include "../custom/metadata.impl.hpp"
+
+namespace nmfs::structures::indexing_types::inline_attributes {
+
+template<typename indexing>
+metadata<indexing>::metadata(nmfs::structures::super_object<indexing>& super, nmfs::owner_slice key, uid_t owner, gid_t group, mode_t mode)
+    : nmfs::structures::indexing_types::custom::metadata<indexing>(super, std::move(key), owner, group, mode) {
+}
+
+template<typename indexing>
+metadata<indexing>::metadata(nmfs::structures::super_object<indexing>& super, nmfs::owner_slice key, const nmfs::structures::on_disk::metadata* on_disk_data)
+    : nmfs::structures::indexing_types::custom::metadata<indexing>(super, std::move(key), on_disk_data) {
+}
+
+template<typename indexing>
+metadata<indexing>::metadata(metadata&& other, nmfs::owner_slice key)
+    : nmfs::structures::indexing_types::custom::metadata<indexing>(std::move(other), std::move(key)),
+      path(std::move(other.path)) {
+}
+
+template<typename indexing>
+metadata<indexing>::~metadata() {
+    metadata::flush();
+}
+
+template<typename indexing>
+void metadata<indexing>::flush() const {
+    if (S_ISREG(this->mode)) {
+        auto flush_lock = std::unique_lock(*this->flush_mutex);
+        if (this->valid && this->dirty.exchange(false)) {
+            auto entry = typename indexing::directory_entry_type(std::string(get_filename(path)), *this);
+
+            this->context.cache->update_entry(path, std::move(entry));
+        }
+    } else {
+        nmfs::structures::indexing_types::custom::metadata<indexing>::flush();
+    }
+}
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INLINE_ATTRIBUTES_METADATA_IMPL_HPP
@@ -0,0 +1,67 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INODE_INDEXING_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INODE_INDEXING_HPP
+
+#include <optional>
+#include <string_view>
+#include <sys/stat.h>
+#include "../../../utils.hpp"
+#include "../../../memory_slices/borrower_slice.hpp"
+#include "../../super_object.hpp"
+#include "../../../local_caches/cache_store.hpp"
+#include "../custom/directory_entry.hpp"
+#include "../custom/metadata.hpp"
+#include "../custom/on_disk/metadata.hpp"
+
+namespace nmfs::structures::indexing_types::inode {
+
+/**
+ * Indexing which keys directories and regular files by a UUID kept in the entry of their parent directory
+ *
+ * File names exist only in directory entries, so renaming a file or a directory of any size moves one entry and
+ * no object. Only the root directory is keyed by its path. Entries and metadata are stored as in custom indexing.
+ */
+template<template<typename> typename caching_policy_type>
+class indexing {
+public:
+    using caching_policy = caching_policy_type<indexing>;
+    using directory_entry_type = nmfs::structures::indexing_types::custom::directory_entry<indexing>;
+    using metadata_type = nmfs::structures::indexing_types::custom::metadata<indexing>;
+    using on_disk_metadata_type = nmfs::structures::indexing_types::custom::on_disk::metadata;
+
+    /**
+     * Keys don't depend on paths, so renaming only changes paths of cached entries
+     */
+    static constexpr bool path_keyed = false;
+    /**
+     * Attributes of regular files are only in their metadata objects
+     */
+    static constexpr bool attributes_in_entries = false;
+
+    static inline owner_slice existing_directory_key(super_object<indexing>& context, std::string_view path);
+    static inline owner_slice existing_regular_file_key(super_object<indexing>& context, std::string_view path);
+    /**
+     * Key of an existing file, generated from its entry without opening the parent directory
+     *
+     * Only the UUID in the entry is used, as the root directory has no entry.
+     */
+    static inline owner_slice existing_entry_key(super_object<indexing>& context, std::string_view path, const directory_entry_type& entry);
+    static inline borrower_slice new_directory_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata);
+    static inline borrower_slice new_regular_file_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata);
+    static inline mode_t get_type(super_object<indexing>& context, std::string_view path);
+    static inline metadata_type load_directory_metadata(super_object<indexing>& context, std::string_view path);
+    static inline metadata_type load_regular_file_metadata(super_object<indexing>& context, std::string_view path);
+    /**
+     * Attributes kept in a directory entry, or std::nullopt if they are only in the metadata object
+     */
+    static inline std::optional<struct stat> entry_attributes(const directory_entry_type& entry);
+
+private:
+    /**
+     * Entry of path in its parent directory, which both its type and its key are taken from
+     */
+    static inline directory_entry_type lookup_entry(super_object<indexing>& context, std::string_view path);
+};
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INODE_INDEXING_HPP
@@ -0,0 +1,85 @@
+#ifndef NMFS_STRUCTURES_INDEXING_TYPES_INODE_INDEXING_IMPL_HPP
+#define NMFS_STRUCTURES_INDEXING_TYPES_INODE_INDEXING_IMPL_HPP
+
+#include <functional>
+
+#include "indexing.hpp"
+#include "../../super_object.impl.hpp"
+#include "../../../local_caches/cache_store.impl.hpp"
+#include "../custom/directory_entry.impl.hpp"
+#include "../custom/metadata.impl.hpp"
+#include "../../utils/read_metadata.hpp"
+
+namespace nmfs::structures::indexing_types::inode {
+
+template<template<typename> typename caching_policy_type>
+owner_slice indexing<caching_policy_type>::existing_directory_key(super_object<indexing>& context, std::string_view path) {
+    if (path == "/") {
+        DECLARE_CONST_BORROWER_SLICE(slice, path.data(), path.size());
+        return owner_slice(slice);
+    } else {
+        return existing_entry_key(context, path, lookup_entry(context, path));
+    }
+}
+
+template<template<typename> typename caching_policy_type>
+owner_slice indexing<caching_policy_type>::existing_regular_file_key(super_object<indexing>& context, std::string_view path) {
+    return existing_entry_key(context, path, lookup_entry(context, path));
+}
+
+template<template<typename> typename caching_policy_type>
+owner_slice indexing<caching_policy_type>::existing_entry_key(super_object<indexing>& context, std::string_view path, const directory_entry_type& entry) {
+    auto key = owner_slice(sizeof(uuid_t));
+
+    std::copy(entry.uuid, entry.uuid + sizeof(uuid_t), key.data());
+    return key;
+}
+
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::new_directory_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
+    if (path == "/") {
+        DECLARE_CONST_BORROWER_SLICE(slice, path.data(), path.size());
+        return slice;
+    } else {
+        return borrower_slice(metadata.data_key_base.data(), metadata.data_key_base.size());
+    }
+}
+
+template<template<typename> typename caching_policy_type>
+borrower_slice indexing<caching_policy_type>::new_regular_file_key(super_object<indexing>& context, std::string_view path, metadata_type& metadata) {
+    return borrower_slice(metadata.data_key_base.data(), metadata.data_key_base.size());
+}
+
+template<template<typename> typename caching_policy_type>
+mode_t indexing<caching_policy_type>::get_type(super_object<indexing>& context, std::string_view path) {
+    if (path == "/") {
+        return S_IFDIR;
+    } else {
+        return lookup_entry(context, path).type;
+    }
+}
+
+template<template<typename> typename caching_policy_type>
+typename indexing<caching_policy_type>::metadata_type indexing<caching_policy_type>::load_directory_metadata(super_object<indexing>& context, std::string_view path) {
+    return utils::read_metadata(context, existing_directory_key(context, path));
+}
+
+template<template<typename> typename caching_policy_type>
+typename indexing<caching_policy_type>::metadata_type indexing<caching_policy_type>::load_regular_file_metadata(super_object<indexing>& context, std::string_view path) {
+    return utils::read_metadata(context, existing_regular_file_key(context, path));
+}
+
+template<template<typename> typename caching_policy_type>
+std::optional<struct stat> indexing<caching_policy_type>::entry_attributes(const directory_entry_type& entry) {
+    return std::nullopt;
+}
+
+template<template<typename> typename caching_policy_type>
+typename indexing<caching_policy_type>::directory_entry_type indexing<caching_policy_type>::lookup_entry(super_object<indexing>& context, std::string_view path) {
+    auto open_context = context.cache->template open_directory<std::shared_lock>(get_parent_directory(path));
+    return open_context.directory.get_entry(get_filename(path));
+}
+
+}
+
+#endif //NMFS_STRUCTURES_INDEXING_TYPES_INODE_INDEXING_IMPL_HPP
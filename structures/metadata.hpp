@@ -2,9 +2,12 @@
 #define NMFS_STRUCTURES_METADATA_HPP
 
 #include <sys/stat.h>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include "../primitive_types.hpp"
@@ -20,7 +23,13 @@ class metadata {
 public:
     super_object<indexing>& context;
     owner_slice key;
-    size_t open_count;
+    /**
+     * Number of open contexts taking this metadata, which starts at zero and is changed by openers holding a shared lock
+     *
+     * A directory counts one per opened context. Caching policies keep metadata while it is above zero, and closed
+     * metadata is scheduled to expire once it returns to zero.
+     */
+    std::atomic<size_t> open_count;
     nlink_t link_count;
     uid_t owner;
     gid_t group;
@@ -31,8 +40,12 @@ public:
     struct timespec ctime;
     bool valid = true;
     std::chrono::system_clock::time_point last_close;
-    mutable bool dirty = false;
+    mutable std::atomic<bool> dirty = false;
     mutable std::shared_ptr<std::shared_mutex> mutex;
+    /**
+     * Held while contents are written, so a flush finding this metadata clean returns after the flush which cleaned it
+     */
+    mutable std::shared_ptr<std::mutex> flush_mutex;
 
     inline metadata(super_object<indexing>& super, owner_slice key, uid_t owner, gid_t group, mode_t mode);
     inline metadata(super_object<indexing>& super, owner_slice key, const on_disk::metadata* on_disk_structure);
@@ -45,6 +58,10 @@ public:
     inline ssize_t write(const byte* buffer, size_t size_to_write, off_t offset);
     inline ssize_t read(byte* buffer, size_t size_to_read, off_t offset) const;
     inline void truncate(off_t new_size);
+    /**
+     * Set dirty flag, and register this metadata to the dirty set of cache_store if it was clean
+     */
+    inline void mark_dirty();
     /**
      * Write local metadata contents to backend
      */
@@ -56,9 +73,20 @@ public:
     virtual void move_data(const slice& new_data_key_base) = 0;
     inline void remove();
     constexpr struct stat to_stat() const;
+    /**
+     * Approximate number of bytes this metadata occupies in memory
+     */
+    [[nodiscard]] inline size_t memory_usage() const;
 
 protected:
+    /**
+     * Queue data objects to be removed in the background, which are waited for before they are used again
+     */
     inline void remove_data_objects(uint32_t index_from, uint32_t index_to);
+    /**
+     * Move data objects from keys of one base to another inside the backend
+     */
+    inline void move_data_objects(const slice& old_data_key_base, const slice& new_data_key_base);
     virtual utils::data_object_key get_data_object_key(uint32_t index) const = 0;
     virtual inline void to_on_disk_metadata(on_disk::metadata& on_disk_metadata) const;
 };
@@ -2,6 +2,7 @@
 #define NMFS_STRUCTURES_METADATA_IMPL_HPP
 
 #include <utility>
+#include <vector>
 #include "metadata.hpp"
 #include "../logger/log.hpp"
 #include "../logger/write_bytes.hpp"
@@ -17,7 +18,7 @@ template<typename indexing>
 metadata<indexing>::metadata(super_object<indexing>& super, owner_slice key, uid_t owner, gid_t group, mode_t mode)
     : context(super),
       key(std::move(key)),
-      open_count(1),
+      open_count(0),
       link_count(1),
       owner(owner),
       group(group),
@@ -25,7 +26,8 @@ metadata<indexing>::metadata(super_object<indexing>& super, owner_slice key, uid
       size(0),
       last_close(std::chrono::system_clock::now()),
       dirty(true),
-      mutex(std::make_shared<std::shared_mutex>()) {
+      mutex(std::make_shared<std::shared_mutex>()),
+      flush_mutex(std::make_shared<std::mutex>()) {
     if (timespec_get(&atime, TIME_UTC) != TIME_UTC) {
         throw std::runtime_error("timespec_get failed.");
     }
@@ -37,7 +39,7 @@ template<typename indexing>
 metadata<indexing>::metadata(super_object<indexing>& super, owner_slice key, const on_disk::metadata* on_disk_structure)
     : context(super),
       key(std::move(key)),
-      open_count(1),
+      open_count(0),
       link_count(on_disk_structure->link_count),
       owner(on_disk_structure->owner),
       group(on_disk_structure->group),
@@ -47,7 +49,8 @@ metadata<indexing>::metadata(super_object<indexing>& super, owner_slice key, con
       mtime(on_disk_structure->mtime),
       ctime(on_disk_structure->ctime),
       last_close(std::chrono::system_clock::now()),
-      mutex(std::make_shared<std::shared_mutex>()) {
+      mutex(std::make_shared<std::shared_mutex>()),
+      flush_mutex(std::make_shared<std::mutex>()) {
 }
 
 template<typename indexing>
@@ -66,7 +69,8 @@ metadata<indexing>::metadata(metadata&& other, nmfs::owner_slice key)
       valid(other.valid),
       last_close(std::chrono::system_clock::now()),
       dirty(true),
-      mutex(std::make_shared<std::shared_mutex>()) {
+      mutex(std::make_shared<std::shared_mutex>()),
+      flush_mutex(std::make_shared<std::mutex>()) {
     other.dirty = false;
     other.move_data(key);
     if (key != other.key) {
@@ -92,7 +96,8 @@ metadata<indexing>::metadata(metadata&& other, nmfs::owner_slice key, const slic
       valid(other.valid),
       last_close(std::chrono::system_clock::now()),
       dirty(true),
-      mutex(std::make_shared<std::shared_mutex>()) {
+      mutex(std::make_shared<std::shared_mutex>()),
+      flush_mutex(std::make_shared<std::mutex>()) {
     other.dirty = false;
     other.move_data(new_data_key_base);
     if (key != other.key) {
@@ -106,7 +111,7 @@ template<typename indexing>
 metadata<indexing>::metadata(metadata&& other) noexcept
     : context(other.context),
       key(std::move(other.key)),
-      open_count(other.open_count),
+      open_count(other.open_count.load()),
       link_count(other.link_count),
       owner(other.owner),
       group(other.group),
@@ -117,8 +122,9 @@ metadata<indexing>::metadata(metadata&& other) noexcept
       ctime(other.ctime),
       valid(other.valid),
       last_close(other.last_close),
-      dirty(other.dirty),
-      mutex(std::move(other.mutex)) {
+      dirty(other.dirty.load()),
+      mutex(std::move(other.mutex)),
+      flush_mutex(other.flush_mutex) {
     other.valid = false;
 }
 
@@ -127,6 +133,8 @@ ssize_t metadata<indexing>::write(const byte* buffer, size_t size_to_write, off_
     log::information(log_locations::file_data_operation) << std::showbase << std::hex << "(" << this << ") " << __func__ << "(size = " << size_to_write << ", offset = " << offset << ")\n";
     log::information(log_locations::file_data_content) << std::showbase << std::hex << "(" << this << ") " << __func__ << " = " << write_bytes(buffer, size_to_write) << '\n';
 
+    // Objects of a truncated file still being removed would remove what is written now
+    context.cache->wait_for_reclamation(key);
     auto data_key = nmfs::structures::utils::data_object_key(key, static_cast<uint32_t>(offset / context.maximum_object_size));
     auto offset_in_object = static_cast<uint32_t>(offset % context.maximum_object_size);
     uint32_t remain_size_in_object = context.maximum_object_size - offset_in_object;
@@ -134,7 +142,7 @@ ssize_t metadata<indexing>::write(const byte* buffer, size_t size_to_write, off_
 
     if (offset + size_to_write > size) {
         size = offset + size_to_write;
-        dirty = true;
+        mark_dirty();
     }
 
     while (remain_size_to_write > 0) {
@@ -156,6 +164,8 @@ template<typename indexing>
 ssize_t metadata<indexing>::read(byte* buffer, size_t size_to_read, off_t offset) const {
     log::information(log_locations::file_data_operation) << std::showbase << std::hex << "(" << this << ") " << __func__ << "(size = " << size_to_read << ", offset = " << offset << ")\n";
 
+    // Objects of a truncated file still being removed would be read back after it grows again
+    context.cache->wait_for_reclamation(key);
     auto data_key = nmfs::structures::utils::data_object_key(key, static_cast<uint32_t>(offset / context.maximum_object_size));
     auto offset_in_object = static_cast<uint32_t>(offset % context.maximum_object_size);
     uint32_t remain_size_in_object = context.maximum_object_size - offset_in_object;
@@ -204,18 +214,45 @@ void metadata<indexing>::truncate(off_t new_size) {
             remove_data_objects(first_index, last_index);
         }
         size = new_size;
-        dirty = true;
+        mark_dirty();
+    }
+}
+
+template<typename indexing>
+void metadata<indexing>::mark_dirty() {
+    if (!dirty.exchange(true)) {
+        context.cache->mark_dirty(*this);
     }
 }
 
 template<typename indexing>
 void metadata<indexing>::remove_data_objects(uint32_t index_from, uint32_t index_to) {
     log::information(log_locations::file_data_operation) << std::showbase << std::hex << __func__ << "(index_from = " << index_from << ", index_to = " << index_to << ")\n";
-    auto data_key = nmfs::structures::utils::data_object_key(key, index_from);
-    for (uint32_t i = index_from; i <= index_to; i++) {
-        data_key.update_index(i);
-        context.backend->remove(data_key);
+    context.cache->reclaim(key, index_from, index_to);
+}
+
+template<typename indexing>
+void metadata<indexing>::move_data_objects(const slice& old_data_key_base, const slice& new_data_key_base) {
+    log::information(log_locations::file_data_operation) << std::showbase << std::hex << "(" << this << ") " << __func__ << "()\n";
+    if (size == 0) {
+        return;
+    }
+
+    // Objects of a replaced file still being removed may be under either base
+    context.cache->wait_for_reclamation(old_data_key_base);
+    context.cache->wait_for_reclamation(new_data_key_base);
+    auto number_of_objects = static_cast<uint32_t>(size / context.maximum_object_size + 1);
+    std::vector<owner_slice> old_keys;
+    std::vector<owner_slice> new_keys;
+
+    old_keys.reserve(number_of_objects);
+    new_keys.reserve(number_of_objects);
+    for (uint32_t i = 0; i < number_of_objects; i++) {
+        old_keys.emplace_back(utils::data_object_key(old_data_key_base, i));
+        new_keys.emplace_back(utils::data_object_key(new_data_key_base, i));
     }
+    // Holes are skipped, as objects never written don't exist
+    context.backend->move(old_keys, new_keys);
 }
 
 template<typename indexing>
@@ -249,6 +286,11 @@ void metadata<indexing>::to_on_disk_metadata(on_disk::metadata& on_disk_metadata
     on_disk_metadata.ctime = ctime;
 }
 
+template<typename indexing>
+size_t metadata<indexing>::memory_usage() const {
+    return sizeof(typename indexing::metadata_type) + key.capacity();
+}
+
 template<typename indexing>
 constexpr struct stat metadata<indexing>::to_stat() const {
     struct stat stat{
@@ -0,0 +1,62 @@
+#ifndef NMFS_STRUCTURES_ON_DISK_DIRECTORY_HPP
+#define NMFS_STRUCTURES_ON_DISK_DIRECTORY_HPP
+
+#include <cstdint>
+#include "../../primitive_types.hpp"
+
+namespace nmfs::structures::on_disk {
+
+/**
+ * Header object of a directory begins with directory_header, followed by directory_fragment of each fragment
+ */
+struct directory_header {
+    static constexpr uint32_t current_magic = 0x48444d4e; // "NMDH"
+    static constexpr uint32_t current_version = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    on_disk_size_type number_of_fragments;
+};
+
+struct directory_fragment {
+    uint32_t id;
+    on_disk_size_type number_of_files;
+    on_disk_size_type size;
+};
+
+/**
+ * Object of a directory fragment begins with fragment_image, followed by offsets of restart points and entries sorted
+ * by file name. Changes made after the image was encoded are appended from image_size to the end of the object.
+ *
+ * Each entry is a fragment_record followed by the part of its file name not shared with the previous entry and the
+ * rest of the serialized entry. Every restart_interval-th entry is a restart point, which shares nothing.
+ */
+struct fragment_image {
+    static constexpr uint32_t current_magic = 0x444d464e; // "NFMD"
+    static constexpr uint32_t current_version = 2;
+
+    uint32_t magic;
+    uint32_t version;
+    on_disk_size_type number_of_entries;
+    on_disk_size_type image_size;
+    uint32_t restart_interval;
+};
+
+struct fragment_record {
+    uint16_t shared_size;
+    uint16_t unshared_size;
+    uint16_t value_size;
+};
+
+/**
+ * Marker of a change appended to a fragment object, followed by a serialized entry for update, or a file name
+ * length and the file name for remove
+ */
+enum class fragment_change: uint8_t {
+    update = 1,
+    remove = 2,
+};
+
+}
+
+#endif //NMFS_STRUCTURES_ON_DISK_DIRECTORY_HPP
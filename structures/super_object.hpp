@@ -4,7 +4,7 @@
 #include <memory>
 #include "../local_caches/cache_store.fwd.hpp"
 #include "../kv_backends/kv_backend.hpp"
-#include "../configuration.hpp"
+#include "../mount_options.hpp"
 
 namespace nmfs::structures {
 using namespace nmfs::kv_backends;
@@ -12,14 +12,15 @@ using namespace nmfs::kv_backends;
 template<typename indexing>
 class super_object {
 public:
-    using caching_policy = configuration::caching_policy<indexing>;
+    using caching_policy = typename indexing::caching_policy;
 
     const size_t maximum_object_size = 64 * 1024;
 
+    const mount_options options;
     std::unique_ptr<kv_backend> backend;
     std::unique_ptr<cache_store<indexing, caching_policy>> cache;
 
-    inline explicit super_object(std::unique_ptr<kv_backend> backend);
+    inline super_object(std::unique_ptr<kv_backend> backend, const mount_options& options);
     inline ~super_object();
 };
 
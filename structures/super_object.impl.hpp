@@ -8,8 +8,9 @@
 namespace nmfs::structures {
 
 template<typename indexing>
-super_object<indexing>::super_object(std::unique_ptr<kv_backend> backend)
-    : backend(std::move(backend)),
+super_object<indexing>::super_object(std::unique_ptr<kv_backend> backend, const mount_options& options)
+    : options(options),
+      backend(std::move(backend)),
       cache(std::make_unique<cache_store<indexing, caching_policy>>(*this)) {
 }
 
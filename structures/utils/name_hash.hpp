@@ -0,0 +1,39 @@
+#ifndef NMFS_STRUCTURES_UTILS_NAME_HASH_HPP
+#define NMFS_STRUCTURES_UTILS_NAME_HASH_HPP
+
+#include <cstdint>
+#include <string_view>
+
+namespace nmfs::structures::utils {
+
+/**
+ * 32-bit FNV-1a hash of a file name
+ *
+ * Unlike std::hash, the result is stable across builds, so it can decide where an entry is stored.
+ */
+constexpr uint32_t name_hash(std::string_view name) {
+    uint32_t hash = 2166136261u;
+
+    for (char character: name) {
+        hash ^= static_cast<uint8_t>(character);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * 16-bit hash of a file name independent of name_hash, which orders names sharing their name_hash
+ */
+constexpr uint16_t name_tie_break(std::string_view name) {
+    // djb2, folded to 16 bits
+    uint32_t hash = 5381u;
+
+    for (char character: name) {
+        hash = hash * 33u + static_cast<uint8_t>(character);
+    }
+    return static_cast<uint16_t>(hash ^ (hash >> 16));
+}
+
+}
+
+#endif //NMFS_STRUCTURES_UTILS_NAME_HASH_HPP
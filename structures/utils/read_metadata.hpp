@@ -0,0 +1,24 @@
+#ifndef NMFS_STRUCTURES_UTILS_READ_METADATA_HPP
+#define NMFS_STRUCTURES_UTILS_READ_METADATA_HPP
+
+#include <utility>
+#include "../../memory_slices/owner_slice.hpp"
+#include "../on_disk/metadata.hpp"
+#include "../super_object.hpp"
+
+namespace nmfs::structures::utils {
+
+/**
+ * Read the metadata object of the key, whose on-disk structure is indexing::on_disk_metadata_type
+ */
+template<typename indexing>
+inline typename indexing::metadata_type read_metadata(super_object<indexing>& context, owner_slice key) {
+    owner_slice value = context.backend->get(key, sizeof(typename indexing::on_disk_metadata_type));
+    auto on_disk_metadata = reinterpret_cast<const nmfs::structures::on_disk::metadata*>(value.data());
+
+    return typename indexing::metadata_type(context, std::move(key), on_disk_metadata);
+}
+
+}
+
+#endif //NMFS_STRUCTURES_UTILS_READ_METADATA_HPP